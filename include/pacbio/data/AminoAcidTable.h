@@ -0,0 +1,98 @@
+// Copyright (c) 2016-2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace PacBio {
+namespace Data {
+
+/// A codon encoded in six bits, two bits per base in {A, C, G, T}, with the
+/// first base in the most significant bits. Ids are in lexicographic order.
+using CodonId = uint8_t;
+
+class AminoAcidTable
+{
+public:
+    /// Number of valid codon ids
+    static constexpr int NumCodons = 64;
+    /// Id of codons containing other characters than {A, C, G, T}
+    static constexpr CodonId InvalidCodon = NumCodons;
+
+    /// Translation from codon id to amino acid, stop codons are 'X'
+    static constexpr std::array<char, NumCodons> Translation{
+        {'K', 'N', 'K', 'N', 'T', 'T', 'T', 'T', 'R', 'S', 'R', 'S', 'I', 'I', 'M', 'I',
+         'Q', 'H', 'Q', 'H', 'P', 'P', 'P', 'P', 'R', 'R', 'R', 'R', 'L', 'L', 'L', 'L',
+         'E', 'D', 'E', 'D', 'A', 'A', 'A', 'A', 'G', 'G', 'G', 'G', 'V', 'V', 'V', 'V',
+         'X', 'Y', 'X', 'Y', 'S', 'S', 'S', 'S', 'X', 'C', 'W', 'C', 'L', 'F', 'L', 'F'}};
+
+public:
+    /// Two bit encoding of a base, 4 for any other character
+    static constexpr uint8_t BaseToBits(const char b)
+    {
+        return b == 'A' ? 0 : b == 'C' ? 1 : b == 'G' ? 2 : b == 'T' ? 3 : 4;
+    }
+    /// Base of a two bit encoding
+    static constexpr char BitsToBase(const uint8_t bits) { return "ACGT"[bits & 3]; }
+
+    /// Codon id of three bases, InvalidCodon if one is not in {A, C, G, T}
+    static constexpr CodonId ToCodonId(const char a, const char b, const char c)
+    {
+        return (BaseToBits(a) | BaseToBits(b) | BaseToBits(c)) > 3
+                   ? InvalidCodon
+                   : BaseToBits(a) << 4 | BaseToBits(b) << 2 | BaseToBits(c);
+    }
+    /// Codon id of a codon string, InvalidCodon if it is not a valid codon
+    static CodonId ToCodonId(const std::string& codon);
+
+    /// Base at position 0, 1, or 2 of a valid codon id
+    static constexpr char BaseAt(const CodonId id, const int i)
+    {
+        return BitsToBase(id >> (2 * (2 - i)));
+    }
+    /// Codon string of a codon id, empty for InvalidCodon
+    static std::string ToCodon(CodonId id);
+
+    /// Amino acid of a valid codon id
+    static char AminoAcid(const CodonId id) { return Translation[id]; }
+};
+}
+}  //::PacBio::Data
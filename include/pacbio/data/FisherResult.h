@@ -37,6 +37,8 @@
 
 #pragma once
 
+#include <array>
+
 namespace PacBio {
 namespace Data {
 struct FisherResult
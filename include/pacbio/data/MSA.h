@@ -37,10 +37,13 @@
 
 #pragma once
 
+#include <pacbio/data/AminoAcidTable.h>
 #include <pacbio/data/QvThresholds.h>
 
 #include <array>
+#include <limits>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -54,14 +57,22 @@ class MSAColumn;
 struct MSARow;
 class MSAByRow;
 
+/// Counts per codon, indexed by CodonId
+using CodonCounts = std::array<int, AminoAcidTable::NumCodons>;
+/// Quality-weighted counts per codon, indexed by CodonId
+using WeightedCodonCounts = std::array<double, AminoAcidTable::NumCodons>;
+
 /// Represents a multiple sequence alignment (MSA) via individual rows.
 /// Insertions are omitted and saved a special variable of each row.
 class MSAByRow
 {
 public:
     MSAByRow() = default;
-    MSAByRow(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads);
-    MSAByRow(const std::vector<Data::ArrayRead>& reads);
+    /// If weighted, each row additionally stores the probability of each
+    /// codon to be correct, see WeightedCodonTensor.
+    MSAByRow(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads,
+             const bool weighted = false);
+    MSAByRow(const std::vector<Data::ArrayRead>& reads, const bool weighted = false);
 
 public:
     /// The left-most position of all reads in the MSA.
@@ -70,16 +81,23 @@ public:
     int EndPos() const { return endPos_; }
     /// The individual rows of the MSA.
     const std::vector<std::shared_ptr<MSARow>>& Rows() const { return rows_; }
-    /// Easy way to access a row by its name.
+    /// Names of all reads, indexed by row. The row index serves as read id.
     /// The name equivalent to BamRecord::FullName()
-    std::shared_ptr<MSARow> NameToRow(const std::string& name) const { return nameToRow_.at(name); }
+    const std::vector<std::string>& ReadNames() const { return readNames_; }
 
-    std::map<std::string, int> CodonsAt(const int i) const;
+    /// Counts of all valid codons at every window position, thus of all
+    /// three reading frames, gathered in a single pass over each row.
+    std::vector<CodonCounts> CodonTensor() const;
+    /// Same as CodonTensor, each read adds the product of its three base
+    /// probabilities ProbTrue instead of one; bases without QV, or QV 0,
+    /// count as correct. Requires a weighted MSA.
+    std::vector<WeightedCodonCounts> WeightedCodonTensor() const;
 
 private:
     std::vector<std::shared_ptr<MSARow>> rows_;
-    std::map<std::string, std::shared_ptr<MSARow>> nameToRow_;
+    std::vector<std::string> readNames_;
     const Data::QvThresholds qvThresholds_;
+    const bool weighted_ = false;
     int beginPos_ = std::numeric_limits<int>::max();
     int endPos_ = 0;
 
@@ -103,10 +121,16 @@ public:
     std::map<int, std::string> Insertions;
     /// The underlying ArrayRead.
     std::shared_ptr<Data::ArrayRead> Read;
+    /// Probability that the codon starting at each position is correct.
+    /// Only filled in a weighted MSAByRow.
+    std::vector<float> CodonWeights;
+    /// Codon id starting at each position, InvalidCodon if the read has no
+    /// valid codon there. Extracted once, when the row is added.
+    std::vector<CodonId> CodonIds;
 
 public:
     std::string CodonAt(const int pos) const;
-    bool CodingCodonAt(const int winPos, std::string* codon) const;
+    CodonId CodonIdAt(const int winPos) const;
 };
 
 /// Represents a MSA by columns. Each column is a distribution of counts.
@@ -123,6 +147,13 @@ public:
 
 public:
     MSAByColumn(const MSAByRow& nucMat);
+    /// Empty MSA, to be filled read by read via AddRead
+    MSAByColumn() = default;
+
+public:
+    /// Count the bases and insertions of a read directly into the columns,
+    /// without storing the read. Columns are added as reads extend the MSA.
+    void AddRead(const ArrayRead& read);
 
 public:
     /// Parameter is an index in ABSOLUTE reference space
@@ -143,8 +174,13 @@ public:
     /// The right-most position of all reads in the MSA.
     int EndPos() const { return endPos_; }
 
+private:
+    /// Add columns so that the MSA covers [begin, end)
+    void Extend(int begin, int end);
+
 private:
     MsaVec counts;
+    const Data::QvThresholds qvThresholds_;
     int beginPos_ = std::numeric_limits<int>::max();
     int endPos_ = 0;
 };
@@ -180,12 +216,18 @@ public:
     const std::map<std::string, int>& Insertions() const;
     /// P-value for given nucleotide.
     double PValue(const char c) const;
+    /// P-value for given insertion, 1 if it has not been tested.
+    double InsertionPValue(const std::string& seq) const;
 
-public:  // NOT YET USED
-    void IncInsertion(const std::string& seq);
+public:
+    /// Store p-values and significance mask of the nucleotides.
     void AddFisherResult(const FisherResult& f);
+    /// Store p-values of the insertions.
     void AddFisherResult(const std::map<std::string, double>& f);
+    /// Print significant deletions and insertions.
     std::ostream& InDels(std::ostream& stream);
+    /// Count an insertion following this column.
+    void IncInsertion(const std::string& seq);
 
 public:
     friend std::ostream& operator<<(std::ostream& stream, const MSAColumn& r);
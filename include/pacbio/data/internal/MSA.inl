@@ -104,6 +104,12 @@ inline const std::map<std::string, int>& MSAColumn::Insertions() const { return
 
 inline double MSAColumn::PValue(const char c) const { return pValues_.at(NucleotideToTag(c)); }
 
+inline double MSAColumn::InsertionPValue(const std::string& seq) const
+{
+    const auto it = insertionsPValues_.find(seq);
+    return it == insertionsPValues_.cend() ? 1 : it->second;
+}
+
 inline std::ostream& operator<<(std::ostream& stream, const MSAColumn& r)
 {
     for (const auto& b : {'A', 'C', 'G', 'T', '-'})
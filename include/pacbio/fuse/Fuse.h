@@ -38,7 +38,10 @@
 #pragma once
 
 #include <fstream>
+#include <iosfwd>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <pacbio/data/MSA.h>
@@ -50,25 +53,45 @@ namespace Fuse {
 class Fuse
 {
 public:
-    Fuse(const std::string& ccsInput, int minCoverage);
+    /// Reads are partitioned by their reference in a single pass and the
+    /// consensus of each reference is computed on up to numThreads threads.
+    /// A single reference yields one consensus named CONSENSUS, multiple
+    /// references yield one consensus each, named after the reference.
+    Fuse(const std::string& ccsInput, int minCoverage, size_t numThreads = 1);
+    /// Same as above, for records already in memory
+    Fuse(const std::vector<BAM::BamRecord>& records, int minCoverage, size_t numThreads = 1);
     Fuse(const std::vector<Data::ArrayRead>& arrayReads);
 
 public:
-    std::string ConsensusSequence() const { return consensusSequence_; }
+    /// Name of each reference and its consensus, in order of reference id
+    const std::vector<std::pair<std::string, std::string>>& ConsensusSequences() const
+    {
+        return consensusSequences_;
+    }
+
+    /// Greedily select insertions by descending coverage, ties by smaller
+    /// position. A selected insertion at position s suppresses all
+    /// candidates in the half-open window [s - windowSize, s + windowSize).
+    /// Suppressed candidates do not suppress others.
+    static std::map<int, std::string> SelectInsertions(
+        const std::map<int, std::pair<std::string, int>>& posInsCov, int windowSize = 20);
 
 private:
-    std::vector<Data::ArrayRead> FetchAlignedReads(const std::string& ccsInput) const;
-    std::string CreateConsensus(const std::vector<Data::ArrayRead>& arrayReads) const;
+    /// Partition records by reference and compute each consensus
+    template <typename Records>
+    void FuseRecords(Records& records, size_t numThreads);
+    /// Consensus of the column counts of numReads reads, coverage warnings
+    /// are written to warnings
+    std::string CreateConsensus(const Data::MSAByColumn& msa, int numReads,
+                                std::ostream& warnings) const;
     std::map<int, std::pair<std::string, int>> CollectInsertions(
         const Data::MSAByColumn& msa) const;
-    std::pair<int, std::string> FindInsertions(
-        std::map<int, std::pair<std::string, int>>* posInsCov, int windowSize = 20) const;
 
 private:
     const int minCoverageRecommended_ = 50;
     const double minInsertionCoverageFreq_ = 0.5;
 
-    std::string consensusSequence_;
+    std::vector<std::pair<std::string, std::string>> consensusSequences_;
 };
 }
 }  // ::PacBio::Fuse
\ No newline at end of file
@@ -65,6 +65,7 @@ public:
     std::string InputFile;
     std::string OutputFile;
     int MinCoverage = 0;
+    size_t NumThreads = 1;
     int RegionStart = 0;
     int RegionEnd = std::numeric_limits<int>::max();
 };
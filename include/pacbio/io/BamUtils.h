@@ -42,6 +42,7 @@
 #include <string>
 #include <vector>
 
+#include <pbbam/BamRecord.h>
 #include <pbbam/EntireFileQuery.h>
 #include <pbbam/PbiFilterQuery.h>
 
@@ -53,10 +54,22 @@ struct BamUtils
 {
     static std::unique_ptr<BAM::internal::IQuery> BamQuery(const std::string& filePath);
 
+    /// Whether BamToArrayReads converts this record, given the same region
+    static bool IsArrayRead(const BAM::BamRecord& record, int regionStart = 0,
+                            int regionEnd = std::numeric_limits<int>::max());
+
     /// \brief Wrapper around pbbam to ease BAM parsing and region extraction
     static std::vector<std::shared_ptr<Data::ArrayRead>> BamToArrayReads(
         const std::string& filePath, int regionStart = 0,
         int regionEnd = std::numeric_limits<int>::max());
+
+    /// Converts the records accepted by IsArrayRead, in order, clipped to the
+    /// region. The running index of each converted record is its read id.
+    template <typename Records>
+    static std::vector<std::shared_ptr<Data::ArrayRead>> ToArrayReads(
+        Records& records, int regionStart = 0, int regionEnd = std::numeric_limits<int>::max());
 };
 }
-}  // ::PacBio::IO
\ No newline at end of file
+}  // ::PacBio::IO
+
+#include "pacbio/io/internal/BamUtils.inl"
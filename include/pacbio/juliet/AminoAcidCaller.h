@@ -37,14 +37,17 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
 #include <vector>
 
+#include <pacbio/data/AminoAcidTable.h>
 #include <pacbio/data/MSA.h>
 #include <pacbio/juliet/ErrorEstimates.h>
 #include <pacbio/juliet/Haplotype.h>
 #include <pacbio/juliet/TargetConfig.h>
 #include <pacbio/juliet/VariantGene.h>
+#include <pacbio/statistics/Fisher.h>
 #include <pbcopper/json/JSON.h>
 
 namespace PacBio {
@@ -80,7 +83,7 @@ public:
 /// Contains a single codon, it's abundance, and the translated amino acid
 struct MajorityCall
 {
-    std::string Codon;
+    Data::CodonId Codon = Data::AminoAcidTable::InvalidCodon;
     int Coverage = 0;
     char AA;
 };
@@ -100,35 +103,85 @@ public:
 public:
     void PhaseVariants();
 
+    /// Haplotype of each read, indexed by read id, i.e., the order of the
+    /// input reads. Either a reported or a filtered haplotype; null if the
+    /// read has not been phased or was only counted, see maxPatterns_.
+    std::vector<const Haplotype*> ReadHaplotypes() const;
+
+    /// Reported haplotypes, named and sorted by descending size
+    const std::vector<Haplotype>& Haplotypes() const { return reconstructedHaplotypes_; }
+    /// Haplotypes filtered by their flags, by ascending size
+    const std::vector<Haplotype>& FilteredHaplotypes() const { return filteredHaplotypes_; }
+    /// Names of all reads, indexed by read id
+    const std::vector<std::string>& ReadNames() const { return msaByRow_.ReadNames(); }
+
+    /// Expectation-maximization of the proportions of a mixture of
+    /// generators, each with fixed hard counts. Soft items, each with a read
+    /// count, are assigned fractionally given their likelihoods under each
+    /// generator, a row-major matrix with one row per soft item.
+    /// Returns the expected soft counts of each generator.
+    static std::vector<double> SoftCounts(const std::vector<double>& hard,
+                                          const std::vector<double>& likelihoods,
+                                          const std::vector<double>& readCounts);
+
+    /// Merge satellites, haplotypes that differ from a larger on-target
+    /// haplotype in the codon of a single variant position, into it, unless
+    /// their abundance is significant given the error model. Only haplotypes
+    /// with a codon id at every position are considered; signatures are the
+    /// codon ids of each haplotype. Satellites are visited largest first, thus a
+    /// haplotype that absorbed satellites is never merged itself. Returns the
+    /// number of merged haplotypes.
+    int MergeSatellites(std::vector<std::shared_ptr<Haplotype>>* haplotypes,
+                        const std::vector<std::vector<Data::CodonId>>& signatures);
+
+    /// Compute the probabilities of all codon pairs under the error model,
+    /// indexed by a * NumCodons + b.
+    static std::array<double, Data::AminoAcidTable::NumCodons * Data::AminoAcidTable::NumCodons>
+    CodonProbabilities(const ErrorEstimates& error);
+
+    /// Codon counts of all window positions, weighted counts are rounded
+    static std::vector<Data::CodonCounts> CodonTensor(const Data::MSAByRow& msa,
+                                                      const bool weighted);
+
 private:
     /// Finds the major codon given the codon map
-    static MajorityCall FindMajorityCodon(const std::map<std::string, int>& codons);
+    static MajorityCall FindMajorityCodon(const Data::CodonCounts& codons);
 
 private:
     static constexpr float alpha = 0.01;
+    /// Number of slices of the rows, each with its own pattern summary
+    static constexpr size_t patternSlices = 8;
     void CallVariants();
 
     /// Counts the number of tests that will be performed.
     /// This number can be used to bonferroni correct p-values.
     int CountNumberOfTests(const std::vector<TargetGene>& genes) const;
 
-    /// Find those drugs associated with the current variant and generate
-    /// a summary string.
-    std::string FindDRMs(const std::string& geneName, const std::vector<TargetGene>& genes,
-                         const DMutation curDRM) const;
+    /// Probability that the two codons generated each other via sequencing
+    /// noise, looked up from the precomputed matrix.
+    double Probability(const Data::CodonId a, const Data::CodonId b) const;
+
+    /// Counts of the MSA columns surrounding the codon at the absolute
+    /// reference position, from three bases before to three bases after.
+    std::vector<JSON::Json> MSAContext(const int absPos) const;
 
-    /// Compute the probability that the two strings generated each other
-    /// via sequencing noise.
-    double Probability(const std::string& a, const std::string& b);
+    /// Fractionally assign the reads of filtered haplotypes, e.g., partial
+    /// or with gaps, to the generators by expectation-maximization of the
+    /// generator proportions, see SoftCounts. Off-target haplotypes are
+    /// skipped. Stored as soft read counts of the generators.
+    void SoftAssign(const std::vector<std::shared_ptr<Haplotype>>& generators,
+                    const std::vector<std::shared_ptr<Haplotype>>& filtered) const;
 
     /// Compute if the current variant hits an expected minor and
     /// use it to measure the performance of juliet.
-    bool MeasurePerformance(const TargetGene& tg, const std::string& codon,
+    bool MeasurePerformance(const TargetGene& tg, const Data::CodonId codon,
                             const bool& variableSite, const int& aaPos, const double& p,
                             PerformanceMetrics* pm);
 
 private:
     Data::MSAByRow msaByRow_;
+    // Codon counts by window position, of all three reading frames
+    const std::vector<Data::CodonCounts> codonCounts_;
 
 public:
     Data::MSAByColumn msaByColumn_;
@@ -138,10 +191,23 @@ private:
     std::vector<Haplotype> reconstructedHaplotypes_;
     std::vector<Haplotype> filteredHaplotypes_;
     const ErrorEstimates error_;
+    // Codon to codon probabilities under error_, see Probability
+    const std::array<double, Data::AminoAcidTable::NumCodons * Data::AminoAcidTable::NumCodons>
+        codonProbabilities_;
+    // Fisher's exact test engine, log-factorials cached up to the max coverage
+    const Statistics::Fisher fisher_;
+    // Repeated contingency tables are answered from this cache
+    Statistics::FisherCache fisherCache_;
     const TargetConfig targetConfig_;
     const bool verbose_;
     const bool debug_;
+    const size_t numThreads_;
     const bool drmOnly_;
+    const bool mergeSatellites_;
+    const bool softAssign_;
+    // Capacity of the read pattern summary of each slice, 0 is unbounded.
+    // Bounds the haplotypes and their read ids, not the rows of msaByRow_.
+    const size_t maxPatterns_;
     const double minimalPerc_;
     const double maximalPerc_;
 
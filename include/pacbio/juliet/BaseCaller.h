@@ -0,0 +1,90 @@
+// Copyright (c) 2016-2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <pacbio/data/ArrayRead.h>
+#include <pacbio/data/MSA.h>
+#include <pacbio/juliet/ErrorEstimates.h>
+#include <pacbio/juliet/TargetConfig.h>
+#include <pacbio/statistics/Fisher.h>
+#include <pbcopper/json/JSON.h>
+
+namespace PacBio {
+namespace Juliet {
+struct JulietSettings;
+
+/// Given a MSA and noise model, compute variant nucleotides, deletions, and
+/// insertions of each column and generate machine-interpretable output.
+/// Intended for non-coding targets, where codon-level calling does not apply.
+/// Insertions are tested against the deletion rate, as the insertion rate is
+/// not estimated.
+class BaseCaller
+{
+public:
+    BaseCaller(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads,
+               const ErrorEstimates& error, const JulietSettings& settings);
+
+public:
+    /// Generate JSON output of variant nucleotides and insertions
+    JSON::Json JSON() const;
+
+private:
+    static constexpr float alpha = 0.01;
+    void CallVariants();
+
+    /// Counts the number of tests that will be performed.
+    /// This number can be used to bonferroni correct p-values.
+    int CountNumberOfTests() const;
+
+public:
+    Data::MSAByColumn msaByColumn_;
+
+private:
+    const ErrorEstimates error_;
+    // Fisher's exact test engine, log-factorials cached up to the max coverage
+    const Statistics::Fisher fisher_;
+    // Repeated contingency tables are answered from this cache
+    Statistics::FisherCache fisherCache_;
+    const TargetConfig targetConfig_;
+    const bool verbose_;
+    const bool debug_;
+    const double minimalPerc_;
+};
+}
+}  // ::PacBio::Juliet
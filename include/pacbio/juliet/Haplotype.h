@@ -57,16 +57,15 @@ class Haplotype
 {
 public:
     Haplotype() = delete;
-    Haplotype(const std::string readName, const std::vector<std::string>& codons,
-              const HaplotypeType& flag)
-        : readNames_({readName}), codons_(codons), numCodons_(codons_.size())
+    Haplotype(const int readId, const std::vector<std::string>& codons, const HaplotypeType& flag)
+        : readIds_({readId}), codons_(codons), numCodons_(codons_.size())
     {
         AddFlag(flag);
         SetFlagsByCodons();
     }
-    Haplotype(const std::vector<std::string> readNames, std::vector<std::string>&& codons,
+    Haplotype(const std::vector<int> readIds, std::vector<std::string>&& codons,
               const HaplotypeType flag)
-        : readNames_(readNames)
+        : readIds_(readIds)
         , codons_(std::forward<std::vector<std::string>>(codons))
         , numCodons_(codons_.size())
     {
@@ -77,12 +76,14 @@ public:
 public:  // non-mod methods
     /// How many reads contributed to this haplotype
     double Size() const;
+    /// Number of reads, with or without id, excluding soft counts
+    int NumReads() const;
     /// Concat all codons to one string without seperator
     std::string ConcatCodons() const;
-    /// Convert this to a JSON string
-    JSON::Json ToJson() const;
-    // All read names
-    const std::vector<std::string>& ReadNames() const;
+    /// Convert this to a JSON string, read ids are resolved to their names
+    JSON::Json ToJson(const std::vector<std::string>& readNames) const;
+    // All read ids, i.e., indices into the shared read name table
+    const std::vector<int>& ReadIds() const;
     // All codons
     const std::string& Codon(const int i);
     // Number of codons
@@ -90,7 +91,9 @@ public:  // non-mod methods
     // Combined flags
     int Flags() const;
     // Name of this haplotype
-    std::string Name();
+    std::string Name() const;
+    // Names of the set HaplotypeType flags, comma separated
+    std::string FlagNames() const;
 
 public:  // mod methods
     /// Set appropriate HaplotypeFlags from already stored codons
@@ -100,7 +103,12 @@ public:  // mod methods
     /// Set the frequency of this
     void Frequency(const double& freq);
     /// Add additional read
-    void AddReadName(const std::string& name);
+    void AddReadId(const int readId);
+    /// Add reads that are only counted, without their ids. The count may
+    /// overestimate the true number of reads by at most countError.
+    void AddUntrackedReads(const int count, const int countError);
+    /// Add all reads of another haplotype
+    void AddReads(const Haplotype& other);
     /// Add a fraction of reads as soft counts
     void AddSoftReadCount(const double s);
     /// Set name of this haplotype
@@ -111,7 +119,9 @@ public:
 
 private:
     std::string name_;
-    std::vector<std::string> readNames_;
+    std::vector<int> readIds_;
+    int untrackedReads_ = 0;
+    int countError_ = 0;
     const std::vector<std::string> codons_;
     size_t numCodons_;
     double softCollapses_ = 0;
@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/juliet/Haplotype.h>
+
+namespace PacBio {
+namespace Juliet {
+
+/// Open-addressing table of haplotype indices, keyed by the hash of their
+/// packed codon ids. Lookups confirm candidates with equal hash by a predicate,
+/// as codons without an id, with gaps or Ns, share a hash.
+class HaplotypeIndex
+{
+public:
+    static constexpr int Empty = -1;
+    static constexpr uint64_t HashSeed = 14695981039346656037ULL;
+
+public:
+    HaplotypeIndex() : slots_(64, Slot{0, Empty}) {}
+
+public:
+    /// FNV-1a step, adding one codon id to the hash
+    static uint64_t Hash(const uint64_t hash, const Data::CodonId codon);
+
+    /// Index of the first haplotype with this hash for which same(index)
+    /// holds, Empty if there is none
+    template <typename Same>
+    int Find(const uint64_t hash, const Same& same) const;
+
+    /// Register the haplotype at index in the haplotypes vector
+    void Insert(const uint64_t hash, const int index);
+
+private:
+    struct Slot
+    {
+        uint64_t hash;
+        int index;
+    };
+
+    void Place(const Slot& slot);
+
+private:
+    std::vector<Slot> slots_;
+    size_t size_ = 0;
+};
+
+/// Haplotypes observed in a slice of reads, in order of first occurrence
+struct Observations
+{
+    std::vector<std::shared_ptr<Haplotype>> haplotypes;
+    // Codon ids of each haplotype and their hash
+    std::vector<std::vector<Data::CodonId>> signatures;
+    std::vector<uint64_t> hashes;
+    HaplotypeIndex index;
+
+    /// Index of the haplotype with these codon ids, Empty if there is none.
+    /// Codons without an id can only be told apart by their bases, given
+    /// by codonAt(j).
+    template <typename CodonAt>
+    int Find(const uint64_t hash, const std::vector<Data::CodonId>& ids,
+             const CodonAt& codonAt) const;
+
+    /// Append a haplotype that has not been observed yet
+    void Add(const uint64_t hash, const std::vector<Data::CodonId>& ids,
+             std::shared_ptr<Haplotype> h);
+};
+}
+}  //::PacBio::Juliet
+
+#include "pacbio/juliet/internal/HaplotypeIndex.inl"
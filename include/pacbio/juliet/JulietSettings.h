@@ -37,6 +37,7 @@
 
 #pragma once
 
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -64,24 +65,32 @@ public:
 public:
     /// Parses the provided CLI::Results and retrieves a defined set of options.
     JulietSettings(const PacBio::CLI::Results& options);
+    /// Defaults of all options, e.g., to call without command line.
+    JulietSettings() = default;
 
 public:
     std::string CLI;
     std::vector<std::string> InputFiles;
     std::string OutputPrefix;
+    std::string HaplotypeBam;
     TargetConfig TargetConfigUser;
     int RegionStart = 0;
     int RegionEnd = std::numeric_limits<int>::max();
-    bool DRMOnly;
-    bool SaveMSA;
-    bool Verbose;
-    bool Debug;
+    bool DRMOnly = false;
+    bool SaveMSA = false;
+    bool Verbose = false;
+    bool Debug = false;
+    bool WeightedCounts = false;
+    bool MergeSatellites = false;
+    bool SoftAssign = false;
+    size_t MaxPatterns = 0;
+    size_t NumThreads = 1;
 
-    AnalysisMode Mode;
-    double SubstitutionRate;
-    double DeletionRate;
-    double MinimalPerc;
-    double MaximalPerc;
+    AnalysisMode Mode = AnalysisMode::AMINO;
+    double SubstitutionRate = 0;
+    double DeletionRate = 0;
+    double MinimalPerc = 0.1;
+    double MaximalPerc = 100;
 };
 }
 }  // ::PacBio::Juliet
\ No newline at end of file
@@ -38,11 +38,13 @@
 #pragma once
 
 #include <fstream>
+#include <string>
 
 #include <pacbio/juliet/JulietSettings.h>
 
 namespace PacBio {
 namespace Juliet {
+class AminoAcidCaller;
 
 /// Provides a method to execute the complete Juliet workflow
 class JulietWorkflow
@@ -55,6 +57,11 @@ private:
     std::ostream& LogCI(const std::string& prefix);
     void AminoPhasing(const JulietSettings& settings);
     void Error(const JulietSettings& settings);
+    /// Copy all records of the input to the output BAM file, in a single
+    /// streaming pass. Reads are tagged with their haplotype, looked up by
+    /// their read id, the index among the reads converted from the input.
+    void StoreHaplotypeBam(const JulietSettings& settings, const std::string& bamInput,
+                           const AminoAcidCaller& aac);
 };
 }
 }  // ::PacBio::Juliet
\ No newline at end of file
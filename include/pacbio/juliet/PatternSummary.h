@@ -0,0 +1,92 @@
+// Copyright (c) 2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <pacbio/juliet/Haplotype.h>
+
+namespace PacBio {
+namespace Juliet {
+
+/// Space-Saving summary of the most frequent read patterns with a fixed
+/// number of counters. Once full, a new pattern replaces the one with the
+/// smallest count and inherits it. Thus counts are upper bounds, exceeding
+/// the true count by at most their error.
+class PatternSummary
+{
+public:
+    struct Counter
+    {
+        std::string pattern;
+        HaplotypeType flag;
+        int count;
+        int error;
+    };
+
+public:
+    explicit PatternSummary(const size_t capacity) : capacity_(capacity) {}
+
+public:
+    /// Count a pattern
+    void Add(const std::string& pattern, const HaplotypeType flag, const int count = 1,
+             const int error = 0);
+
+    /// Merge the summary of another slice. Patterns missing from a full
+    /// summary may have been counted up to its smallest count.
+    void Merge(const PatternSummary& other);
+
+    /// Tracked patterns
+    const std::vector<Counter>& Counters() const { return counters_; }
+
+    /// Upper bound of the count of any untracked pattern
+    int MinCount() const { return counters_.size() < capacity_ ? 0 : byCount_.cbegin()->first; }
+
+private:
+    const size_t capacity_;
+    std::vector<Counter> counters_;
+    std::unordered_map<std::string, size_t> slots_;
+    std::set<std::pair<int, size_t>> byCount_;
+};
+}
+}  //::PacBio::Juliet
@@ -40,6 +40,7 @@
 #include <pbcopper/json/JSON.h>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace PacBio {
@@ -110,6 +111,40 @@ public:
 public:
     JSON::Json ToJson() const;
     static JSON::Json ToJson(const std::vector<TargetGene>& genes);
+
+public:
+    /// (Re-)builds the position index of drms, call after modifying drms.
+    void IndexDRMs();
+    /// True if at least one drm is annotated at the amino acid position
+    bool HasDRMs(int aaPos) const;
+    /// Find those drugs associated with the current variant and generate
+    /// a summary string, drugs are listed in the order of drms.
+    std::string FindDRMs(const DMutation& curDRM) const;
+
+private:
+    // Amino acid position to all DMutations at this position, each with the
+    // index of its drm
+    std::unordered_map<int, std::vector<std::pair<size_t, DMutation>>> drmsByPosition_;
+};
+
+/// Interval index over the [begin, end) ranges of genes, answers which genes
+/// overlap a reference range without visiting all genes.
+class TargetGeneIndex
+{
+public:
+    TargetGeneIndex(const std::vector<TargetGene>& genes);
+
+public:
+    /// Indices of all genes overlapping [begin, end), in input order
+    std::vector<size_t> Overlapping(int begin, int end) const;
+
+private:
+    // Gene indices, sorted by begin
+    std::vector<size_t> byBegin_;
+    std::vector<int> begins_;
+    std::vector<int> ends_;
+    // Maximal end of all genes up to this one in byBegin_ order, non-decreasing
+    std::vector<int> maxEnds_;
 };
 
 /// The whole config with genes, information about the reference, and version
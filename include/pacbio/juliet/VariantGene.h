@@ -37,11 +37,16 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <pacbio/data/AminoAcidTable.h>
 #include <pbcopper/json/JSON.h>
 
 namespace PacBio {
@@ -54,30 +59,57 @@ struct VariantGene
 
     struct VariantPosition
     {
-        std::string refCodon;
-        std::string altRefCodon;
+        VariantPosition() { hitRows_.fill(-1); }
+
+        Data::CodonId refCodon = Data::AminoAcidTable::InvalidCodon;
+        Data::CodonId altRefCodon = Data::AminoAcidTable::InvalidCodon;
         char refAminoAcid;
         char altRefAminoAcid;
-        std::vector<JSON::Json> msa;
+        // Absolute reference position of the codon, used to render the
+        // surrounding MSA counts on output
+        int absPos = -1;
         int coverage;
 
         struct VariantCodon
         {
-            std::string codon;
+            Data::CodonId codon;
             double frequency;
             double pValue;
             std::string knownDRM;
-            std::vector<bool> haplotypeHit;
         };
         std::map<char, std::vector<VariantCodon>> aminoAcidToCodons;
 
         bool IsVariant() const;
-        bool IsHit(const std::string& codon);
+        /// Codon is the reference, the alternative reference, or a variant
+        /// codon. Requires IndexCodons.
+        bool IsHit(const Data::CodonId codon) const;
+
+        /// Index the accepted codons and assign each variant codon a row in
+        /// the hit matrix. Call once all variant codons have been added.
+        void IndexCodons();
+        /// Allocate an empty hit matrix of variant codons x haplotypes
+        void ResetHits(const size_t numHaplotypes);
+        /// Mark the haplotype as carrying the codon, returns false if the
+        /// codon is no variant codon
+        bool SetHit(const Data::CodonId codon, const size_t haplotype);
+        /// Which haplotypes carry the variant codon
+        std::vector<bool> HaplotypeHits(const Data::CodonId codon) const;
+
+    private:
+        std::bitset<Data::AminoAcidTable::NumCodons> acceptedCodons_;
+        // Row of each variant codon in hits_, -1 for other codons
+        std::array<int, Data::AminoAcidTable::NumCodons> hitRows_;
+        size_t numHaplotypes_ = 0;
+        size_t wordsPerRow_ = 0;
+        // Row-major bit matrix, one row of haplotype bits per variant codon
+        std::vector<uint64_t> hits_;
     };
 
     std::map<int, std::shared_ptr<VariantPosition>> relPositionToVariant;
 
-    JSON::Json ToJson() const;
+    /// MSA context of each variant position is rendered on demand, given
+    /// its absolute reference position.
+    JSON::Json ToJson(const std::function<std::vector<JSON::Json>(int)>& msaContext) const;
 };
 }
 }  // ::PacBio::Juliet
\ No newline at end of file
@@ -61,5 +61,10 @@ inline double PerformanceMetrics::Accuracy() const
     return (TruePositives + TrueNegative) /
            (TruePositives + FalsePositives + FalseNegative + TrueNegative);
 }
+
+inline double AminoAcidCaller::Probability(const Data::CodonId a, const Data::CodonId b) const
+{
+    return codonProbabilities_[a * Data::AminoAcidTable::NumCodons + b];
+}
 }
 }  // ::PacBio::Juliet
\ No newline at end of file
@@ -0,0 +1,65 @@
+// Copyright (c) 2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+namespace PacBio {
+namespace Juliet {
+
+inline std::vector<uint64_t> PackSignature(const std::vector<Data::CodonId>& ids)
+{
+    std::vector<uint64_t> words((ids.size() + 7) / 8, 0);
+    for (size_t j = 0; j < ids.size(); ++j)
+        words[j / 8] |= static_cast<uint64_t>(ids[j]) << (8 * (j % 8));
+    return words;
+}
+
+inline int HammingDistance(const uint64_t* a, const uint64_t* b, const size_t numWords,
+                           const int maxDistance)
+{
+    // Codon ids, including InvalidCodon, fit into the low seven bits
+    static_assert(Data::AminoAcidTable::InvalidCodon < 128, "Codon ids exceed seven bits");
+    static constexpr uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    int distance = 0;
+    for (size_t w = 0; w < numWords && distance <= maxDistance; ++w) {
+        const uint64_t x = a[w] ^ b[w];
+        // High bit of each byte is set iff the byte is non-zero
+        const uint64_t nonZero = (((x & low7) + low7) | x) & ~low7;
+        distance += std::bitset<64>(nonZero).count();
+    }
+    return distance;
+}
+}
+}  //::PacBio::Juliet
@@ -38,12 +38,11 @@
 namespace PacBio {
 namespace Juliet {
 
-inline double Haplotype::Size() const { return readNames_.size() + softCollapses_; }
+inline double Haplotype::Size() const { return NumReads() + softCollapses_; }
 
-inline const std::vector<std::string>& Haplotype::ReadNames() const
-{
-    return const_cast<std::vector<std::string>&>(readNames_);
-}
+inline int Haplotype::NumReads() const { return readIds_.size() + untrackedReads_; }
+
+inline const std::vector<int>& Haplotype::ReadIds() const { return readIds_; }
 
 inline const std::string& Haplotype::Codon(const int i) { return codons_.at(i); }
 
@@ -51,13 +50,25 @@ inline size_t Haplotype::NumCodons() const { return numCodons_; }
 
 inline int Haplotype::Flags() const { return flags_; }
 
-inline std::string Haplotype::Name() { return name_; }
+inline std::string Haplotype::Name() const { return name_; }
 
 inline void Haplotype::AddFlag(const HaplotypeType& flag) { flags_ |= static_cast<int>(flag); }
 
 inline void Haplotype::Frequency(const double& freq) { frequency_ = freq; }
 
-inline void Haplotype::AddReadName(const std::string& name) { readNames_.push_back(name); }
+inline void Haplotype::AddReadId(const int readId) { readIds_.push_back(readId); }
+
+inline void Haplotype::AddUntrackedReads(const int count, const int countError)
+{
+    untrackedReads_ += count;
+    countError_ += countError;
+}
+
+inline void Haplotype::AddReads(const Haplotype& other)
+{
+    readIds_.insert(readIds_.end(), other.readIds_.cbegin(), other.readIds_.cend());
+    AddUntrackedReads(other.untrackedReads_, other.countError_);
+}
 
 inline void Haplotype::AddSoftReadCount(const double s) { softCollapses_ += s; }
 
@@ -0,0 +1,102 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <utility>
+
+namespace PacBio {
+namespace Juliet {
+
+inline uint64_t HaplotypeIndex::Hash(const uint64_t hash, const Data::CodonId codon)
+{
+    return (hash ^ codon) * 1099511628211ULL;
+}
+
+template <typename Same>
+int HaplotypeIndex::Find(const uint64_t hash, const Same& same) const
+{
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask; slots_[i].index != Empty; i = (i + 1) & mask)
+        if (slots_[i].hash == hash && same(slots_[i].index)) return slots_[i].index;
+    return Empty;
+}
+
+inline void HaplotypeIndex::Insert(const uint64_t hash, const int index)
+{
+    // Keep load factor at most one half
+    if (2 * (size_ + 1) > slots_.size()) {
+        std::vector<Slot> old(2 * slots_.size(), Slot{0, Empty});
+        std::swap(old, slots_);
+        for (const auto& slot : old)
+            if (slot.index != Empty) Place(slot);
+    }
+    Place(Slot{hash, index});
+    ++size_;
+}
+
+inline void HaplotypeIndex::Place(const Slot& slot)
+{
+    const size_t mask = slots_.size() - 1;
+    size_t i = slot.hash & mask;
+    while (slots_[i].index != Empty)
+        i = (i + 1) & mask;
+    slots_[i] = slot;
+}
+
+template <typename CodonAt>
+int Observations::Find(const uint64_t hash, const std::vector<Data::CodonId>& ids,
+                       const CodonAt& codonAt) const
+{
+    return index.Find(hash, [&](const int i) {
+        if (signatures[i] != ids) return false;
+        for (size_t j = 0; j < ids.size(); ++j)
+            if (ids[j] == Data::AminoAcidTable::InvalidCodon &&
+                haplotypes[i]->Codon(j) != codonAt(j))
+                return false;
+        return true;
+    });
+}
+
+inline void Observations::Add(const uint64_t hash, const std::vector<Data::CodonId>& ids,
+                              std::shared_ptr<Haplotype> h)
+{
+    index.Insert(hash, haplotypes.size());
+    haplotypes.emplace_back(std::move(h));
+    signatures.push_back(ids);
+    hashes.push_back(hash);
+}
+}
+}  //::PacBio::Juliet
@@ -7,21 +7,131 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace PacBio {
 namespace Statistics {
+/// One-sided Fisher's exact test engine.
+/// Owns a log-factorial table that is filled once at construction and only
+/// read afterwards, thus a single instance can be shared across threads.
 class Fisher
 {
 public:
+    /// Precompute log-factorials for 2x2 tables whose total count, the sum of
+    /// all four cells, is at most maxTotal. Larger tables fall back to lgamma.
+    Fisher(int maxTotal = 0);
+
+public:
+    /// P-value of observing chi11 or more co-occurrences.
+    /// Tails longer than MaxTailTerms are computed with TailSaddlePoint, unless
+    /// chi11 is within MinSaddlePointDeviations of its mean.
+    double ExactTiss(int chi11, int chi12, int chi21, int chi22) const;
+
+    /// P-values of all candidates at one position, sharing the same coverage.
+    /// Each candidate is tested as 2x2 table of its observed counts against its
+    /// expected counts, i.e.,
+    /// (observed, coverage - observed, ceil(expected), ceil(coverage - expected)).
+    std::vector<double> ExactTiss(int coverage, const std::vector<int>& observed,
+                                  const std::vector<double>& expected) const;
+
+    /// Decides if the p-value is smaller than threshold, without computing it
+    /// exactly. Tail summation stops once the outcome is certain.
+    bool IsSignificant(int chi11, int chi12, int chi21, int chi22, double threshold) const;
+
+    /// P-value by summing all hypergeometric probabilities of the tail.
+    double TailSum(int chi11, int chi12, int chi21, int chi22) const;
+
+    /// P-value by double saddlepoint approximation in constant time.
+    /// For tails longer than MaxTailTerms and chi11 at least
+    /// MinSaddlePointDeviations standard deviations above its mean, the
+    /// relative error compared to TailSum is below 1e-3 and decreases with
+    /// increasing counts. Closer to the mean, the error grows up to 0.5.
+    /// Returns -1 if the approximation is undefined, i.e., chi11 is at the
+    /// boundary or too close to the mean.
+    static double TailSaddlePoint(int chi11, int chi12, int chi21, int chi22);
+
+public:
+    /// Maximal number of tail terms to sum before switching to the
+    /// saddlepoint approximation.
+    static constexpr int MaxTailTerms = 1000;
+    /// Minimal distance of chi11 to its mean, in standard deviations of the
+    /// hypergeometric distribution, for the saddlepoint approximation.
+    static constexpr double MinSaddlePointDeviations = 3;
+    /// Largest total cached by the engine of fisher_exact_tiss
+    static constexpr int WrapperMaxTotal = 100;
+
+public:
+    /// Thin wrapper using a process-wide engine, with log-factorials cached up
+    /// to a total of WrapperMaxTotal.
     static double fisher_exact_tiss(int chi11, int chi12, int chi21, int chi22);
 
 private:
+    /// Saddlepoint p-value if the tail is longer than MaxTailTerms and chi11
+    /// is far enough from its mean, otherwise -1
+    static double LongTail(int chi11, int chi12, int chi21, int chi22);
+    /// Sum of the tail starting with the probability of the given table.
+    /// With a positive threshold, summation stops as soon as the sum is known
+    /// to be above or below it; the result is then only valid for comparison.
+    double TailSum(int chi11, int chi12, int chi21, int chi22, double base_p,
+                   double threshold = 0) const;
     static double factorInc(int chi11, int chi12, int chi21, int chi22);
     static double factorDec(int chi11, int chi12, int chi21, int chi22);
     static double gammln(double xx);
-    static double factln0(int n);
-    static double factln(int n);
-    static double binomialln(int n, int k);
-    static double calc_hypergeom(int chi11, int chi12, int chi21, int chi22);
+    double factln(int n) const;
+    double binomialln(int n, int k) const;
+    double calc_hypergeom(int chi11, int chi12, int chi21, int chi22) const;
+
+private:
+    std::vector<double> factln_;
+};
+
+/// Bounded memoization of Fisher p-values keyed by the 2x2 table.
+/// Identical tables occur frequently at uniform depth, e.g., for common
+/// single-error codons. Lookups are thread-safe; once capacity is reached,
+/// the cache is flushed and refilled with the tables of current interest.
+class FisherCache
+{
+public:
+    FisherCache(const Fisher& fisher, size_t capacity = 1 << 16);
+
+public:
+    /// Same as the batched Fisher::ExactTiss, repeated tables are answered
+    /// from the cache.
+    std::vector<double> ExactTiss(int coverage, const std::vector<int>& observed,
+                                  const std::vector<double>& expected);
+
+    /// Same as Fisher::IsSignificant on the table of a single candidate as
+    /// built by ExactTiss. Answered from a cached p-value or a cached decision
+    /// against the same threshold.
+    bool IsSignificant(int coverage, int observed, double expected, double threshold);
+
+public:
+    /// Number of p-values and decisions answered from the cache
+    uint64_t Hits() const { return hits_; }
+    /// Number of p-values and decisions that had to be computed
+    uint64_t Misses() const { return misses_; }
+
+private:
+    using Table = std::array<int, 4>;
+    struct TableHash
+    {
+        size_t operator()(const Table& t) const;
+    };
+
+private:
+    const Fisher& fisher_;
+    const size_t capacity_;
+    std::unordered_map<Table, double, TableHash> pValues_;
+    std::unordered_map<Table, std::pair<double, bool>, TableHash> decisions_;
+    std::mutex mutex_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
 };
 }
-}  //::PacBio::Statistics
\ No newline at end of file
+}  //::PacBio::Statistics
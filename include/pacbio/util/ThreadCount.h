@@ -1,4 +1,4 @@
-// Copyright (c) 2016-2017, Pacific Biosciences of California, Inc.
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
 //
 // All rights reserved.
 //
@@ -38,16 +38,26 @@
 #pragma once
 
 #include <algorithm>
-#include <string>
-#include <unordered_map>
+#include <cstddef>
+#include <thread>
 
 namespace PacBio {
-namespace Juliet {
+namespace Util {
 
-class AminoAcidTable
+/// Given the number of threads requested by the user, determine the number
+/// of threads to use, 0 and negative values relative to the number of
+/// available cores.
+inline size_t ThreadCount(int n)
 {
-public:
-    static const std::unordered_map<std::string, char> FromCodon;
-};
+    const int m = std::thread::hardware_concurrency();
+
+    // Number of cores is unknown
+    if (m < 1) return std::max(1, n);
+
+    if (n < 1) return std::max(1, m + n);
+
+    return std::min(m, n);
 }
-}  //::PacBio::Juliet
\ No newline at end of file
+
+}  // namespace Util
+}  // namespace PacBio
@@ -35,8 +35,12 @@
 
 // Author: Armin Töpfer
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
@@ -50,33 +54,49 @@
 #include <numeric>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include <boost/optional.hpp>
 
+#include <pacbio/data/AminoAcidTable.h>
 #include <pacbio/data/ArrayRead.h>
 #include <pacbio/juliet/AminoAcidCaller.h>
-#include <pacbio/juliet/AminoAcidTable.h>
+#include <pacbio/juliet/CodonSignature.h>
 #include <pacbio/juliet/ErrorEstimates.h>
+#include <pacbio/juliet/HaplotypeIndex.h>
 #include <pacbio/juliet/JulietSettings.h>
+#include <pacbio/juliet/PatternSummary.h>
 #include <pacbio/statistics/Fisher.h>
 #include <pacbio/util/Termcolor.h>
 #include <pbcopper/json/JSON.h>
 
 namespace PacBio {
 namespace Juliet {
-using AAT = AminoAcidTable;
+using AAT = Data::AminoAcidTable;
+
+constexpr size_t AminoAcidCaller::patternSlices;
+constexpr int HaplotypeIndex::Empty;
+constexpr uint64_t HaplotypeIndex::HashSeed;
 
 AminoAcidCaller::AminoAcidCaller(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads,
                                  const ErrorEstimates& error, const JulietSettings& settings)
-    : msaByRow_(reads)
+    : msaByRow_(reads, settings.WeightedCounts)
+    , codonCounts_(CodonTensor(msaByRow_, settings.WeightedCounts))
     , msaByColumn_(msaByRow_)
     , error_(error)
+    , codonProbabilities_(CodonProbabilities(error_))
+    , fisher_(2 * msaByRow_.Rows().size() + 1)
+    , fisherCache_(fisher_)
     , targetConfig_(settings.TargetConfigUser)
     , verbose_(settings.Verbose)
     , debug_(settings.Debug)
+    , numThreads_(settings.NumThreads)
     , drmOnly_(settings.DRMOnly)
+    , mergeSatellites_(settings.MergeSatellites)
+    , softAssign_(settings.SoftAssign)
+    , maxPatterns_(settings.MaxPatterns)
     , minimalPerc_(settings.MinimalPerc)
     , maximalPerc_(settings.MaximalPerc)
 {
@@ -86,8 +106,11 @@ AminoAcidCaller::AminoAcidCaller(const std::vector<std::shared_ptr<Data::ArrayRe
 int AminoAcidCaller::CountNumberOfTests(const std::vector<TargetGene>& genes) const
 {
     int numberOfTests = 0;
-    for (const auto& gene : genes) {
-        for (int i = gene.begin; i < gene.end - 2; ++i) {
+    for (const size_t g :
+         TargetGeneIndex(genes).Overlapping(msaByRow_.BeginPos(), msaByRow_.EndPos())) {
+        const auto& gene = genes[g];
+        for (int i = std::max(gene.begin, msaByRow_.BeginPos());
+             i < std::min(gene.end, msaByRow_.EndPos()) - 2; ++i) {
             // Relative to gene begin
             const int relPos = i - gene.begin;
             // Only work on beginnings of a codon
@@ -95,34 +118,14 @@ int AminoAcidCaller::CountNumberOfTests(const std::vector<TargetGene>& genes) co
             // Relative to window begin
             const int winPos = i - msaByRow_.BeginPos();
             // Gather all observed codons and count number of different codons
-            std::map<std::string, int> codons = msaByRow_.CodonsAt(winPos);
-            numberOfTests += codons.size();
+            const auto& codons = codonCounts_[winPos];
+            numberOfTests += std::count_if(codons.cbegin(), codons.cend(),
+                                           [](const int count) { return count > 0; });
         }
     }
     return numberOfTests == 0 ? 1 : numberOfTests;
 }
 
-std::string AminoAcidCaller::FindDRMs(const std::string& geneName,
-                                      const std::vector<TargetGene>& genes,
-                                      const DMutation curDRM) const
-{
-    std::string drmSummary;
-    for (const auto& gene : genes) {
-        if (geneName == gene.name) {
-            for (const auto& drms : gene.drms) {
-
-                if (std::find(drms.positions.cbegin(), drms.positions.cend(), curDRM) !=
-                    drms.positions.cend()) {
-                    if (!drmSummary.empty()) drmSummary += " + ";
-                    drmSummary += drms.name;
-                }
-            }
-            break;
-        }
-    }
-    return drmSummary;
-};
-
 void AminoAcidCaller::PhaseVariants()
 {
     // Store variant positions by their absolute position
@@ -133,6 +136,8 @@ void AminoAcidCaller::PhaseVariants()
                 variantPositions.emplace_back(
                     std::make_pair(vg.geneOffset + pos_vp.first * 3, pos_vp.second));
     }
+    for (auto& pos_var : variantPositions)
+        pos_var.second->IndexCodons();
 
     // Print positions
     if (verbose_) {
@@ -142,58 +147,141 @@ void AminoAcidCaller::PhaseVariants()
         std::cerr << std::endl;
     }
 
-    // Storage for all observed haplotypes, for now
-    std::vector<std::shared_ptr<Haplotype>> observations;
+    // Patterns are keyed by their codon ids, or by their codons separated by
+    // PatternSeparator if one has no id
+    static constexpr char NonCodingPattern = '\xff';
+    static constexpr char PatternSeparator = '|';
+
+    // Collapse the rows [begin, end) into haplotypes, or only count their
+    // patterns if a summary is given
+    const auto& rows = msaByRow_.Rows();
+    auto CollapseRows = [&](const size_t begin, const size_t end, Observations* obs,
+                            PatternSummary* summary) {
+        std::vector<Data::CodonId> ids(variantPositions.size());
+        for (size_t r = begin; r < end; ++r) {
+            const auto& row = rows[r];
+            // Get all codon ids for this row
+            HaplotypeType flag = HaplotypeType::REPORT;
+            uint64_t hash = HaplotypeIndex::HashSeed;
+            bool coding = true;
+            for (size_t j = 0; j < variantPositions.size(); ++j) {
+                const auto& pos_var = variantPositions[j];
+                ids[j] = row->CodonIdAt(pos_var.first - msaByRow_.BeginPos() - 3);
+                hash = HaplotypeIndex::Hash(hash, ids[j]);
+                coding &= ids[j] != AAT::InvalidCodon;
+
+                // If this codon is not a variant, flag haplotype as off-target
+                if (!pos_var.second->IsHit(ids[j])) flag = HaplotypeType::OFFTARGET;
+            }
 
-    // For each read
-    for (const auto& row : msaByRow_.Rows()) {
-        // Get all codons for this row
-        std::vector<std::string> codons;
-        HaplotypeType flag = HaplotypeType::REPORT;
-        for (const auto& pos_var : variantPositions) {
-            const std::string codon = row->CodonAt(pos_var.first - msaByRow_.BeginPos() - 3);
+            // Codons without an id can only be told apart by their bases
+            std::vector<std::string> codons;
+            if (!coding) {
+                for (const auto& pos_var : variantPositions)
+                    codons.emplace_back(row->CodonAt(pos_var.first - msaByRow_.BeginPos() - 3));
+            }
 
-            // If this codon is not a variant, flag haplotype as off-target
-            if (!pos_var.second->IsHit(codon)) flag = HaplotypeType::OFFTARGET;
+            if (summary) {
+                std::string pattern;
+                if (coding) {
+                    pattern.assign(ids.cbegin(), ids.cend());
+                } else {
+                    pattern = NonCodingPattern;
+                    for (const auto& codon : codons)
+                        pattern += codon + PatternSeparator;
+                }
+                summary->Add(pattern, flag);
+                continue;
+            }
 
-            codons.emplace_back(std::move(codon));
+            // Collapse current row into an existing haplotype, if possible
+            const int idx = obs->Find(
+                hash, ids, [&codons](size_t j) -> const std::string& { return codons[j]; });
+            if (idx != HaplotypeIndex::Empty) {
+                obs->haplotypes[idx]->AddReadId(r);
+            } else {
+                if (coding) {
+                    for (const auto& id : ids)
+                        codons.emplace_back(AAT::ToCodon(id));
+                }
+                obs->Add(hash, ids, std::make_shared<Haplotype>(r, std::move(codons), flag));
+            }
         }
+    };
 
-        // There are already haplotypes to compare against
-        int miss = true;
+    // Rows are split into contiguous slices, collapsed by the threads in
+    // turn. Approximate pattern counts depend on the slicing, thus summaries
+    // use a fixed number of slices, independent of the number of threads.
+    const size_t numSlices = std::max<size_t>(
+        1, std::min<size_t>(maxPatterns_ > 0 ? patternSlices : numThreads_, rows.size()));
+    std::vector<Observations> slices(numSlices);
+    std::vector<PatternSummary> summaries;
+    for (size_t t = 0; maxPatterns_ > 0 && t < numSlices; ++t)
+        summaries.emplace_back(maxPatterns_);
+    {
+        std::atomic<size_t> nextSlice{0};
+        auto CollapseSlices = [&]() {
+            for (size_t t = nextSlice++; t < numSlices; t = nextSlice++)
+                CollapseRows(rows.size() * t / numSlices, rows.size() * (t + 1) / numSlices,
+                             &slices[t], summaries.empty() ? nullptr : &summaries[t]);
+        };
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < std::min(numThreads_, numSlices); ++t)
+            threads.emplace_back(CollapseSlices);
+        for (auto& thread : threads)
+            thread.join();
+    }
 
-        // Compare current row to existing haplotypes
-        auto CompareHaplotypes = [&miss, &codons,
-                                  &row](std::vector<std::shared_ptr<Haplotype>>& haplotypes) {
-            for (auto& h : haplotypes) {
-                // Don't trust if the number of codons differ.
-                // That should only be the case if reads are not full-spanning.
-                if (h->NumCodons() != codons.size()) {
-                    continue;
-                }
-                bool same = true;
-                for (size_t i = 0; i < codons.size(); ++i) {
-                    if (h->Codon(i) != codons.at(i)) {
-                        same = false;
-                        break;
-                    }
-                }
-                if (same) {
-                    h->AddReadName(row->Read->Name());
-                    miss = false;
-                    break;
+    // Merge slices in row order. Haplotypes keep the order of their first
+    // read and their read names stay in row order, as if collapsed serially.
+    Observations merged;
+    if (!summaries.empty()) {
+        // Convert the tracked patterns into haplotypes without read ids
+        for (size_t t = 1; t < summaries.size(); ++t)
+            summaries.front().Merge(summaries[t]);
+        for (const auto& c : summaries.front().Counters()) {
+            std::vector<Data::CodonId> ids;
+            std::vector<std::string> codons;
+            if (c.pattern.empty() || c.pattern.front() != NonCodingPattern) {
+                ids.assign(c.pattern.cbegin(), c.pattern.cend());
+                for (const auto& id : ids)
+                    codons.emplace_back(AAT::ToCodon(id));
+            } else {
+                std::istringstream patternStream(c.pattern.substr(1));
+                std::string codon;
+                while (std::getline(patternStream, codon, PatternSeparator)) {
+                    ids.push_back(AAT::ToCodonId(codon));
+                    codons.emplace_back(std::move(codon));
                 }
             }
-        };
-
-        CompareHaplotypes(observations);
-
-        // If row could not be collapsed into an existing haplotype
-        if (miss) {
-            observations.emplace_back(
-                std::make_shared<Haplotype>(row->Read->Name(), std::move(codons), flag));
+            uint64_t hash = HaplotypeIndex::HashSeed;
+            for (const auto& id : ids)
+                hash = HaplotypeIndex::Hash(hash, id);
+            auto h = std::make_shared<Haplotype>(std::vector<int>(), std::move(codons), c.flag);
+            h->AddUntrackedReads(c.count, c.error);
+            merged.Add(hash, ids, std::move(h));
+        }
+        if (verbose_) std::cerr << "#Tracked patterns: " << merged.haplotypes.size() << std::endl;
+    }
+    for (auto& slice : slices) {
+        for (size_t i = 0; i < slice.haplotypes.size(); ++i) {
+            auto& h = slice.haplotypes[i];
+            const int idx =
+                merged.Find(slice.hashes[i], slice.signatures[i],
+                            [&h](size_t j) -> const std::string& { return h->Codon(j); });
+            if (idx != HaplotypeIndex::Empty) {
+                merged.haplotypes[idx]->AddReads(*h);
+            } else {
+                merged.Add(slice.hashes[i], slice.signatures[i], std::move(h));
+            }
         }
     }
+    auto& observations = merged.haplotypes;
+
+    if (mergeSatellites_) {
+        const int numMerged = MergeSatellites(&observations, merged.signatures);
+        if (verbose_) std::cerr << "#Merged satellites: " << numMerged << std::endl;
+    }
 
     // Generators are haplotypes that have been identified as on target
     std::vector<std::shared_ptr<Haplotype>> generators;
@@ -215,7 +303,8 @@ void AminoAcidCaller::PhaseVariants()
     std::sort(generators.begin(), generators.end(), HaplotypeComp);
     std::sort(filtered.begin(), filtered.end(), HaplotypeComp);
 
-    // TODO: matrix solution in J
+    // Fractionally assign reads of filtered haplotypes to the generators
+    if (softAssign_) SoftAssign(generators, filtered);
 
     if (verbose_) std::cerr << "#Haplotypes: " << generators.size() << std::endl;
     double counts = 0;
@@ -229,6 +318,9 @@ void AminoAcidCaller::PhaseVariants()
                          return a->Size() >= b->Size();
                      });
 
+    for (auto& pos_var : variantPositions)
+        pos_var.second->ResetHits(generators.size());
+
     static constexpr int alphabetSize = 26;
     bool doubleName = generators.size() > alphabetSize;
     for (size_t genNumber = 0; genNumber < generators.size(); ++genNumber) {
@@ -248,20 +340,16 @@ void AminoAcidCaller::PhaseVariants()
         // Print
         if (verbose_) std::cerr << (hn->Size() / counts) << "\t" << hn->Size() << "\t";
 
-        // For each variant position, loop through all amino acids and their
-        // mutated codons and store which variant this haplotype hit
+        // For each variant position, store which variant codon this
+        // haplotype hit
         size_t numCodons = hn->NumCodons();
         for (size_t i = 0; i < numCodons; ++i) {
-            for (auto& kv : variantPositions.at(i).second->aminoAcidToCodons) {
-                for (auto& vc : kv.second) {
-                    bool hit = hn->Codon(i) == vc.codon;
-                    vc.haplotypeHit.push_back(hit);
-                    if (hit) {
-                        std::cerr << termcolor::red;
-                    }
-                }
+            const bool hit =
+                variantPositions.at(i).second->SetHit(AAT::ToCodonId(hn->Codon(i)), genNumber);
+            if (verbose_) {
+                if (hit) std::cerr << termcolor::red;
+                std::cerr << hn->Codon(i) << termcolor::reset << " ";
             }
-            if (verbose_) std::cerr << hn->Codon(i) << termcolor::reset << " ";
         }
         if (verbose_) std::cerr << std::endl;
 
@@ -272,9 +360,9 @@ void AminoAcidCaller::PhaseVariants()
 
     // From here on only verbose output
     const auto PrintHaplotype = [&variantPositions, this](std::shared_ptr<Haplotype> h) {
-        for (const auto& name : h->ReadNames()) {
-            std::cerr << name << "\t";
-            const auto& row = msaByRow_.NameToRow(name);
+        for (const int id : h->ReadIds()) {
+            std::cerr << msaByRow_.ReadNames()[id] << "\t";
+            const auto& row = msaByRow_.Rows()[id];
             for (const auto& pos_var : variantPositions)
                 std::cerr << row->CodonAt(pos_var.first - msaByRow_.BeginPos() - 3) << "\t";
             std::cerr << std::endl;
@@ -284,7 +372,7 @@ void AminoAcidCaller::PhaseVariants()
 
     if (verbose_) std::cerr << std::endl << "HAPLOTYPES" << std::endl;
     for (auto& hn : generators) {
-        genCounts_ += hn->ReadNames().size();
+        genCounts_ += hn->NumReads();
         if (verbose_) std::cerr << "HAPLOTYPE: " << hn->Name() << std::endl;
         if (verbose_) PrintHaplotype(hn);
     }
@@ -293,7 +381,7 @@ void AminoAcidCaller::PhaseVariants()
 
     if (verbose_) std::cerr << "FILTERED" << std::endl;
     for (auto& h : filtered) {
-        filteredCounts[h->Flags()] += h->ReadNames().size();
+        filteredCounts[h->Flags()] += h->NumReads();
         if (verbose_) PrintHaplotype(h);
         filteredHaplotypes_.emplace_back(*h);
     }
@@ -322,32 +410,204 @@ void AminoAcidCaller::PhaseVariants()
     }
 }
 
-double AminoAcidCaller::Probability(const std::string& a, const std::string& b)
+std::vector<const Haplotype*> AminoAcidCaller::ReadHaplotypes() const
 {
-    if (a.size() != b.size()) return 0.0;
-
-    double p = 1;
-    for (size_t i = 0; i < a.size(); ++i) {
-        if (a[i] == '-' || b[i] == '-')
-            p *= error_.Deletion;
-        else if (a[i] != b[i])
-            p *= error_.Substitution;
-        else
-            p *= error_.Match;
+    std::vector<const Haplotype*> readHaplotypes(msaByRow_.Rows().size(), nullptr);
+    for (const auto* haplotypes : {&reconstructedHaplotypes_, &filteredHaplotypes_})
+        for (const auto& h : *haplotypes)
+            for (const int id : h.ReadIds())
+                readHaplotypes[id] = &h;
+    return readHaplotypes;
+}
+
+int AminoAcidCaller::MergeSatellites(std::vector<std::shared_ptr<Haplotype>>* haplotypes,
+                                     const std::vector<std::vector<Data::CodonId>>& signatures)
+{
+    auto& haps = *haplotypes;
+    if (haps.empty()) return 0;
+
+    // Parents are on target, satellites may carry a codon that is no variant
+    static constexpr int offTarget = static_cast<int>(HaplotypeType::OFFTARGET);
+    const size_t numWords = (signatures.front().size() + 7) / 8;
+    std::vector<uint64_t> packed(haps.size() * numWords);
+    std::vector<size_t> parents;
+    std::vector<size_t> satellites;
+    for (size_t i = 0; i < haps.size(); ++i) {
+        const auto& ids = signatures[i];
+        if (std::find(ids.cbegin(), ids.cend(), AAT::InvalidCodon) != ids.cend()) continue;
+        const auto words = PackSignature(ids);
+        std::copy(words.cbegin(), words.cend(), packed.begin() + i * numWords);
+        if (haps[i]->Flags() == 0) parents.push_back(i);
+        if ((haps[i]->Flags() & ~offTarget) == 0) satellites.push_back(i);
+    }
+
+    // Largest first. A parent only grows after it has been visited as a
+    // satellite itself, as it must be larger than the absorbed satellite;
+    // merged satellites are thus never chained.
+    const auto NumReads = [&haps](const size_t i) { return haps[i]->NumReads(); };
+    const auto Larger = [&](const size_t a, const size_t b) { return NumReads(a) > NumReads(b); };
+    std::stable_sort(parents.begin(), parents.end(), Larger);
+    std::stable_sort(satellites.begin(), satellites.end(), Larger);
+
+    int numMerged = 0;
+    std::vector<bool> merged(haps.size(), false);
+    for (const size_t s : satellites) {
+        for (const size_t p : parents) {
+            if (merged[p] || NumReads(p) <= NumReads(s)) continue;
+            if (HammingDistance(&packed[p * numWords], &packed[s * numWords], numWords, 1) != 1)
+                continue;
+
+            // Is the satellite explained by sequencing noise of its parent?
+            size_t j = 0;
+            while (signatures[p][j] == signatures[s][j])
+                ++j;
+            const int observed = NumReads(s);
+            const int coverage = NumReads(p) + observed;
+            const double expected = coverage * Probability(signatures[p][j], signatures[s][j]);
+            if (fisherCache_.ExactTiss(coverage, {observed}, {expected}).front() < alpha) continue;
+
+            haps[p]->AddReads(*haps[s]);
+            merged[s] = true;
+            ++numMerged;
+            break;
+        }
+    }
+
+    // Remove merged satellites, keep order of the others
+    size_t k = 0;
+    for (size_t i = 0; i < haps.size(); ++i)
+        if (!merged[i]) haps[k++] = std::move(haps[i]);
+    haps.resize(k);
+    return numMerged;
+}
+
+void AminoAcidCaller::SoftAssign(const std::vector<std::shared_ptr<Haplotype>>& generators,
+                                 const std::vector<std::shared_ptr<Haplotype>>& filtered) const
+{
+    const size_t numGenerators = generators.size();
+    if (numGenerators == 0 || filtered.empty()) return;
+
+    const auto CodonIds = [](const std::shared_ptr<Haplotype>& h) {
+        std::vector<Data::CodonId> ids;
+        for (size_t j = 0; j < h->NumCodons(); ++j)
+            ids.push_back(AAT::ToCodonId(h->Codon(j)));
+        return ids;
+    };
+    std::vector<std::vector<Data::CodonId>> generatorIds;
+    for (const auto& g : generators)
+        generatorIds.emplace_back(CodonIds(g));
+
+    // Likelihood of each filtered haplotype, given each generator, as
+    // row-major matrix. Only observed codons contribute; gaps, Ns, and
+    // uncovered positions are skipped. Rows are scaled by their maximum, as
+    // only their proportions matter.
+    std::vector<double> likelihoods;
+    std::vector<double> readCounts;
+    std::vector<double> row(numGenerators);
+    for (const auto& f : filtered) {
+        // Reads off the target region are not generated by any generator
+        if (f->Flags() & static_cast<int>(HaplotypeType::OFFTARGET)) continue;
+        const auto ids = CodonIds(f);
+        bool observed = false;
+        std::fill(row.begin(), row.end(), 0);
+        for (size_t j = 0; j < ids.size(); ++j) {
+            if (ids[j] == AAT::InvalidCodon) continue;
+            observed = true;
+            for (size_t g = 0; g < numGenerators; ++g)
+                row[g] += std::log(Probability(generatorIds[g][j], ids[j]));
+        }
+        // Reads without any observed codon carry no information
+        if (!observed) continue;
+        const double maxLog = *std::max_element(row.cbegin(), row.cend());
+        for (size_t g = 0; g < numGenerators; ++g)
+            likelihoods.push_back(std::exp(row[g] - maxLog));
+        readCounts.push_back(f->NumReads());
     }
-    return p;
-};
+    if (readCounts.empty()) return;
+
+    std::vector<double> hard(numGenerators);
+    for (size_t g = 0; g < numGenerators; ++g)
+        hard[g] = generators[g]->Size();
+    const auto soft = SoftCounts(hard, likelihoods, readCounts);
+    for (size_t g = 0; g < numGenerators; ++g)
+        generators[g]->AddSoftReadCount(soft[g]);
+}
 
-bool AminoAcidCaller::MeasurePerformance(const TargetGene& tg, const std::string& codon,
+std::vector<double> AminoAcidCaller::SoftCounts(const std::vector<double>& hard,
+                                                const std::vector<double>& likelihoods,
+                                                const std::vector<double>& readCounts)
+{
+    static constexpr int maxIterations = 100;
+    static constexpr double epsilon = 1e-6;
+
+    // Hard counts are fixed, mixture proportions are estimated from hard and
+    // soft counts
+    const size_t numGenerators = hard.size();
+    assert(likelihoods.size() == numGenerators * readCounts.size());
+    const double numHard = std::accumulate(hard.cbegin(), hard.cend(), 0.0);
+    const double numSoft = std::accumulate(readCounts.cbegin(), readCounts.cend(), 0.0);
+
+    // Without hard counts, start from uniform proportions
+    std::vector<double> proportions(numGenerators, 1.0 / numGenerators);
+    if (numHard > 0)
+        for (size_t g = 0; g < numGenerators; ++g)
+            proportions[g] = hard[g] / numHard;
+    std::vector<double> soft(numGenerators);
+    for (int iteration = 0; iteration < maxIterations; ++iteration) {
+        // E-step, expected soft counts of each generator
+        std::fill(soft.begin(), soft.end(), 0);
+        for (size_t f = 0; f < readCounts.size(); ++f) {
+            const double* lik = &likelihoods[f * numGenerators];
+            double sum = 0;
+            for (size_t g = 0; g < numGenerators; ++g)
+                sum += proportions[g] * lik[g];
+            if (sum == 0) continue;
+            const double scale = readCounts[f] / sum;
+            for (size_t g = 0; g < numGenerators; ++g)
+                soft[g] += scale * proportions[g] * lik[g];
+        }
+
+        // M-step, update proportions
+        double maxDelta = 0;
+        for (size_t g = 0; g < numGenerators; ++g) {
+            const double p = (hard[g] + soft[g]) / (numHard + numSoft);
+            maxDelta = std::max(maxDelta, std::abs(p - proportions[g]));
+            proportions[g] = p;
+        }
+        if (maxDelta < epsilon) break;
+    }
+    return soft;
+}
+
+std::array<double, Data::AminoAcidTable::NumCodons * Data::AminoAcidTable::NumCodons>
+AminoAcidCaller::CodonProbabilities(const ErrorEstimates& error)
+{
+    std::array<double, AAT::NumCodons * AAT::NumCodons> probabilities;
+    for (int a = 0; a < AAT::NumCodons; ++a) {
+        for (int b = 0; b < AAT::NumCodons; ++b) {
+            double p = 1;
+            for (int i = 0; i < 3; ++i) {
+                if (AAT::BaseAt(a, i) != AAT::BaseAt(b, i))
+                    p *= error.Substitution;
+                else
+                    p *= error.Match;
+            }
+            probabilities[a * AAT::NumCodons + b] = p;
+        }
+    }
+    return probabilities;
+}
+
+bool AminoAcidCaller::MeasurePerformance(const TargetGene& tg, const Data::CodonId codon,
                                          const bool& variableSite, const int& aaPos,
                                          const double& p, PerformanceMetrics* pm)
 {
-    const char aminoacid = AAT::FromCodon.at(codon);
+    const char aminoacid = AAT::AminoAcid(codon);
     auto Predictor = [&]() {
         if (!tg.minors.empty()) {
             for (const auto& minor : tg.minors) {
                 if (aaPos == minor.position && aminoacid == minor.aminoacid[0] &&
-                    codon == minor.codon) {
+                    codon == AAT::ToCodonId(minor.codon)) {
                     return true;
                 }
             }
@@ -377,20 +637,34 @@ bool AminoAcidCaller::MeasurePerformance(const TargetGene& tg, const std::string
     return predictor;
 }
 
-MajorityCall AminoAcidCaller::FindMajorityCodon(const std::map<std::string, int>& codons)
+std::vector<Data::CodonCounts> AminoAcidCaller::CodonTensor(const Data::MSAByRow& msa,
+                                                            const bool weighted)
+{
+    if (!weighted) return msa.CodonTensor();
+
+    // Fisher's exact test requires integral counts
+    const auto weightedTensor = msa.WeightedCodonTensor();
+    std::vector<Data::CodonCounts> tensor(weightedTensor.size());
+    for (size_t i = 0; i < weightedTensor.size(); ++i)
+        for (int codon = 0; codon < AAT::NumCodons; ++codon)
+            tensor[i][codon] = std::lround(weightedTensor[i][codon]);
+    return tensor;
+}
+
+MajorityCall AminoAcidCaller::FindMajorityCodon(const Data::CodonCounts& codons)
 {
     MajorityCall mc;
     mc.Coverage = -1;
-    for (const auto& codon_counts : codons) {
-        if (codon_counts.second > mc.Coverage) {
-            mc.Coverage = codon_counts.second;
-            mc.Codon = codon_counts.first;
+    for (int codon = 0; codon < AAT::NumCodons; ++codon) {
+        if (codons[codon] > 0 && codons[codon] > mc.Coverage) {
+            mc.Coverage = codons[codon];
+            mc.Codon = codon;
         }
     }
-    if (AAT::FromCodon.find(mc.Codon) == AAT::FromCodon.cend()) {
+    if (mc.Codon == AAT::InvalidCodon) {
         return MajorityCall();
     }
-    mc.AA = AAT::FromCodon.at(mc.Codon);
+    mc.AA = AAT::AminoAcid(mc.Codon);
     return mc;
 }
 
@@ -398,10 +672,13 @@ void AminoAcidCaller::CallVariants()
 {
     auto genes = targetConfig_.targetGenes;
 
-    // If no user config has been provided, use complete input region
+    // If no user config has been provided, use complete input region in all
+    // three forward frames
     if (genes.empty()) {
-        TargetGene tg(msaByRow_.BeginPos(), msaByRow_.EndPos(), "Unnamed ORF", {});
-        genes.emplace_back(tg);
+        for (int frame = 0; frame < 3; ++frame)
+            genes.emplace_back(msaByRow_.BeginPos() + frame, msaByRow_.EndPos(),
+                               "Unnamed ORF, frame " + std::to_string(frame + 1),
+                               std::vector<DRM>());
     }
 
     const int numberOfTests = CountNumberOfTests(genes);
@@ -410,11 +687,15 @@ void AminoAcidCaller::CallVariants()
     const bool hasExpectedMinors = pm.NumExpectedMinors > 0;
     const bool hasReference = !targetConfig_.referenceSequence.empty();
 
-    for (const auto& gene : genes) {
+    // Only genes covered by the MSA window can have variants
+    for (const size_t g :
+         TargetGeneIndex(genes).Overlapping(msaByRow_.BeginPos(), msaByRow_.EndPos())) {
+        const auto& gene = genes[g];
         VariantGene curVariantGene(gene.name, gene.begin);
 
-        // For each codon in the gene
-        for (int i = gene.begin; i < gene.end - 2; ++i) {
+        // For each covered codon in the gene
+        for (int i = std::max(gene.begin, msaByRow_.BeginPos());
+             i < std::min(gene.end, msaByRow_.EndPos()) - 2; ++i) {
             // Absolute reference position
             const int absPos = i - 1;
             // Relative to gene begin
@@ -426,16 +707,19 @@ void AminoAcidCaller::CallVariants()
             // Relative amino acid position
             const int aaPos = 1 + relPos / 3;
 
+            // In DRM-only mode, nothing can be reported at positions without
+            // any annotated DRM. Unless performance is measured, skip them
+            // before counting codons and testing.
+            if (drmOnly_ && !debug_ && !hasExpectedMinors && !gene.HasDRMs(aaPos)) continue;
+
             // Each position is stored in the variant gene
             curVariantGene.relPositionToVariant.emplace(
                 aaPos, std::make_shared<VariantGene::VariantPosition>());
             auto& curVariantPosition = curVariantGene.relPositionToVariant.at(aaPos);
 
             // Gather all observed codons and count actual coverage
-            std::map<std::string, int> codons = msaByRow_.CodonsAt(winPos);
-            int coverage = 0;
-            for (const auto& codon_size : codons)
-                coverage += codon_size.second;
+            const auto& codons = codonCounts_[winPos];
+            const int coverage = std::accumulate(codons.cbegin(), codons.cend(), 0);
 
             // Get the majority codon of the sample
             MajorityCall mc = FindMajorityCodon(codons);
@@ -443,12 +727,13 @@ void AminoAcidCaller::CallVariants()
             // In case a reference has been provided
             if (hasReference) {
                 // Get the reference codon
-                curVariantPosition->refCodon = targetConfig_.referenceSequence.substr(absPos, 3);
-                if (AAT::FromCodon.find(curVariantPosition->refCodon) == AAT::FromCodon.cend()) {
+                curVariantPosition->refCodon =
+                    AAT::ToCodonId(targetConfig_.referenceSequence.substr(absPos, 3));
+                if (curVariantPosition->refCodon == AAT::InvalidCodon) {
                     continue;
                 }
                 // And the corresponding amino acid
-                curVariantPosition->refAminoAcid = AAT::FromCodon.at(curVariantPosition->refCodon);
+                curVariantPosition->refAminoAcid = AAT::AminoAcid(curVariantPosition->refCodon);
 
                 // best alternative to the reference
                 if (mc.Coverage == 0) continue;
@@ -462,54 +747,77 @@ void AminoAcidCaller::CallVariants()
                 curVariantPosition->refAminoAcid = mc.AA;
             }
 
-            for (const auto& codon_counts : codons) {
+            // Codons of interest, all but the reference and alternative reference
+            std::vector<Data::CodonId> candidates;
+            std::vector<int> observed;
+            std::vector<double> expected;
+            for (int codon = 0; codon < AAT::NumCodons; ++codon) {
+                if (codons[codon] == 0) continue;
                 // Skip if the codon of interest is the reference codon
-                if (curVariantPosition->refCodon == codon_counts.first) continue;
+                if (curVariantPosition->refCodon == codon) continue;
                 // Skip if an alternative reference codon is available and it
                 // equals the codon of interest
-                if (!curVariantPosition->altRefCodon.empty() &&
-                    curVariantPosition->altRefCodon == codon_counts.first)
-                    continue;
+                if (curVariantPosition->altRefCodon == codon) continue;
 
+                candidates.push_back(codon);
+                observed.push_back(codons[codon]);
                 // Compute expected counts for null hypothesis that the codon
                 // of interest has been generated by the reference via
                 // sequencing errors.
-                auto expected =
-                    coverage * Probability(curVariantPosition->refCodon, codon_counts.first);
+                expected.push_back(coverage * Probability(curVariantPosition->refCodon, codon));
+            }
 
-                // Compute Fisher's Exact test
-                double p =
-                    (Statistics::Fisher::fisher_exact_tiss(
-                         std::ceil(codon_counts.second), std::ceil(coverage - codon_counts.second),
-                         std::ceil(expected), std::ceil(coverage - expected)) *
-                     numberOfTests);
+            // Exact p-values are only needed for codons that may be stored.
+            // Unless in debug mode, all others are only decided against the
+            // bonferroni corrected threshold and are assigned a p-value of 1.
+            std::vector<double> pValues(candidates.size(), 1);
+            std::vector<size_t> exactIdx;
+            std::vector<int> exactObserved;
+            std::vector<double> exactExpected;
+            for (size_t c = 0; c < candidates.size(); ++c) {
+                if (debug_ ||
+                    fisherCache_.IsSignificant(coverage, observed[c], expected[c],
+                                               alpha / numberOfTests)) {
+                    exactIdx.push_back(c);
+                    exactObserved.push_back(observed[c]);
+                    exactExpected.push_back(expected[c]);
+                }
+            }
+
+            // Compute Fisher's Exact test for those codons at once
+            const auto exactPValues =
+                fisherCache_.ExactTiss(coverage, exactObserved, exactExpected);
+            for (size_t j = 0; j < exactIdx.size(); ++j)
+                pValues[exactIdx[j]] = exactPValues[j];
+
+            for (size_t c = 0; c < candidates.size(); ++c) {
+                const Data::CodonId codon = candidates[c];
+                double p = pValues[c] * numberOfTests;
 
                 // Handle possible overflows
                 if (p > 1) p = 1;
 
                 // Check if there is variability
-                const double frequency = 1.0 * codon_counts.second / coverage;
+                const double frequency = 1.0 * observed[c] / coverage;
                 bool variableSite = frequency < 0.8;
                 // Check if this site is a predictor for known minor variants,
                 // annotated in the TargetConfig.
-                bool predictorSite =
-                    MeasurePerformance(gene, codon_counts.first, variableSite, aaPos, p, &pm);
+                bool predictorSite = MeasurePerformance(gene, codon, variableSite, aaPos, p, &pm);
 
                 // Helper to store an actual variant at the current variant position
                 auto StoreVariant = [&](const std::string& drmString = "") {
                     // Store if minimal percentage is reached or in debug mode
                     if (debug_ || frequency * 100 >= minimalPerc_) {
-                        const char curAA = AAT::FromCodon.at(codon_counts.first);
+                        const char curAA = AAT::AminoAcid(codon);
                         VariantGene::VariantPosition::VariantCodon curVariantCodon;
-                        curVariantCodon.codon = codon_counts.first;
+                        curVariantCodon.codon = codon;
                         curVariantCodon.frequency = frequency;
                         curVariantCodon.pValue = p;
                         if (!drmString.empty())
                             curVariantCodon.knownDRM = drmString;
                         else
-                            curVariantCodon.knownDRM =
-                                FindDRMs(gene.name, genes,
-                                         DMutation(curVariantPosition->refAminoAcid, aaPos, curAA));
+                            curVariantCodon.knownDRM = gene.FindDRMs(
+                                DMutation(curVariantPosition->refAminoAcid, aaPos, curAA));
 
                         curVariantPosition->aminoAcidToCodons[curAA].push_back(curVariantCodon);
                     }
@@ -521,9 +829,8 @@ void AminoAcidCaller::CallVariants()
                 } else if (p < alpha) {  // otherwise, if smaller than the p-value threshold
                     // In DRM-only mode, only store it, if we found DRMs at this position
                     if (drmOnly_) {
-                        const std::string drmString = FindDRMs(
-                            gene.name, genes, DMutation(curVariantPosition->refAminoAcid, aaPos,
-                                                        AAT::FromCodon.at(codon_counts.first)));
+                        const std::string drmString = gene.FindDRMs(DMutation(
+                            curVariantPosition->refAminoAcid, aaPos, AAT::AminoAcid(codon)));
                         if (!drmString.empty()) StoreVariant();
                     } else {  // If we are not in DRM-only mode
                         // In case this is a predictor site of a known variant
@@ -539,35 +846,19 @@ void AminoAcidCaller::CallVariants()
                 }
             }
 
-            // Fill in the MSA counts of the surrounding positions.
-            // Instead of using a special data structure, go directly to JSON
+            // The MSA context is rendered on output, only remember where
             if (!curVariantPosition->aminoAcidToCodons.empty()) {
                 curVariantPosition->coverage = coverage;
-                for (int j = -3; j < 6; ++j) {
-                    if (i + j >= msaByRow_.BeginPos() && i + j < msaByRow_.EndPos()) {
-                        int abs = absPos + j;
-                        JSON::Json msaCounts;
-                        msaCounts["rel_pos"] = j;
-                        msaCounts["abs_pos"] = abs;
-                        msaCounts["A"] = msaByColumn_[abs]['A'];
-                        msaCounts["C"] = msaByColumn_[abs]['C'];
-                        msaCounts["G"] = msaByColumn_[abs]['G'];
-                        msaCounts["T"] = msaByColumn_[abs]['T'];
-                        msaCounts["-"] = msaByColumn_[abs]['-'];
-                        msaCounts["N"] = msaByColumn_[abs]['N'];
-                        if (hasReference)
-                            msaCounts["wt"] =
-                                std::string(1, targetConfig_.referenceSequence.at(abs));
-                        else
-                            msaCounts["wt"] = std::string(1, msaByColumn_[abs].MaxBase());
-                        curVariantPosition->msa.push_back(msaCounts);
-                    }
-                }
+                curVariantPosition->absPos = absPos;
             }
         }
         // Store the gene
         variantGenes_.emplace_back(std::move(curVariantGene));
     }
+    if (verbose_)
+        std::cerr << "Fisher cache hits: " << fisherCache_.Hits()
+                  << ", misses: " << fisherCache_.Misses() << std::endl;
+
     // If minors are expected generate performance metrics
     if (hasExpectedMinors) {
         std::ofstream outValJson("validation.json");
@@ -576,6 +867,32 @@ void AminoAcidCaller::CallVariants()
     }
 }
 
+std::vector<JSON::Json> AminoAcidCaller::MSAContext(const int absPos) const
+{
+    const bool hasReference = !targetConfig_.referenceSequence.empty();
+    std::vector<JSON::Json> msa;
+    for (int j = -3; j < 6; ++j) {
+        const int abs = absPos + j;
+        if (abs + 1 >= msaByRow_.BeginPos() && abs + 1 < msaByRow_.EndPos()) {
+            JSON::Json msaCounts;
+            msaCounts["rel_pos"] = j;
+            msaCounts["abs_pos"] = abs;
+            msaCounts["A"] = msaByColumn_[abs]['A'];
+            msaCounts["C"] = msaByColumn_[abs]['C'];
+            msaCounts["G"] = msaByColumn_[abs]['G'];
+            msaCounts["T"] = msaByColumn_[abs]['T'];
+            msaCounts["-"] = msaByColumn_[abs]['-'];
+            msaCounts["N"] = msaByColumn_[abs]['N'];
+            if (hasReference)
+                msaCounts["wt"] = std::string(1, targetConfig_.referenceSequence.at(abs));
+            else
+                msaCounts["wt"] = std::string(1, msaByColumn_[abs].MaxBase());
+            msa.push_back(msaCounts);
+        }
+    }
+    return msa;
+}
+
 std::string PerformanceMetrics::ToJson() const
 {
     std::stringstream ss;
@@ -593,14 +910,14 @@ JSON::Json AminoAcidCaller::JSON()
     Json root;
     std::vector<Json> genes;
     for (const auto& v : variantGenes_) {
-        Json j = v.ToJson();
+        Json j = v.ToJson([this](const int absPos) { return MSAContext(absPos); });
         if (j.find("variant_positions") != j.cend()) genes.push_back(j);
     }
     root["genes"] = genes;
-    auto HapsToJson = [](const std::vector<Haplotype>& haps) {
+    auto HapsToJson = [this](const std::vector<Haplotype>& haps) {
         std::vector<Json> haplotypes;
         for (const auto& h : haps) {
-            haplotypes.push_back(h.ToJson());
+            haplotypes.push_back(h.ToJson(msaByRow_.ReadNames()));
         }
         return haplotypes;
     };
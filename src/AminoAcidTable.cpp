@@ -35,22 +35,25 @@
 
 // Author: Armin Töpfer
 
-#include <pacbio/juliet/AminoAcidTable.h>
+#include <pacbio/data/AminoAcidTable.h>
 
 namespace PacBio {
-namespace Juliet {
+namespace Data {
 
-const std::unordered_map<std::string, char> AminoAcidTable::FromCodon = {
-    {"ATT", 'I'}, {"ATC", 'I'}, {"ATA", 'I'}, {"CTT", 'L'}, {"CTC", 'L'}, {"CTA", 'L'},
-    {"CTG", 'L'}, {"TTA", 'L'}, {"TTG", 'L'}, {"GTT", 'V'}, {"GTC", 'V'}, {"GTA", 'V'},
-    {"GTG", 'V'}, {"TTT", 'F'}, {"TTC", 'F'}, {"ATG", 'M'}, {"TGT", 'C'}, {"TGC", 'C'},
-    {"GCT", 'A'}, {"GCC", 'A'}, {"GCA", 'A'}, {"GCG", 'A'}, {"GGT", 'G'}, {"GGC", 'G'},
-    {"GGA", 'G'}, {"GGG", 'G'}, {"CCT", 'P'}, {"CCC", 'P'}, {"CCA", 'P'}, {"CCG", 'P'},
-    {"ACT", 'T'}, {"ACC", 'T'}, {"ACA", 'T'}, {"ACG", 'T'}, {"TCT", 'S'}, {"TCC", 'S'},
-    {"TCA", 'S'}, {"TCG", 'S'}, {"AGT", 'S'}, {"AGC", 'S'}, {"TAT", 'Y'}, {"TAC", 'Y'},
-    {"TGG", 'W'}, {"CAA", 'Q'}, {"CAG", 'Q'}, {"AAT", 'N'}, {"AAC", 'N'}, {"CAT", 'H'},
-    {"CAC", 'H'}, {"GAA", 'E'}, {"GAG", 'E'}, {"GAT", 'D'}, {"GAC", 'D'}, {"AAA", 'K'},
-    {"AAG", 'K'}, {"CGT", 'R'}, {"CGC", 'R'}, {"CGA", 'R'}, {"CGG", 'R'}, {"AGA", 'R'},
-    {"AGG", 'R'}, {"TAA", 'X'}, {"TAG", 'X'}, {"TGA", 'X'}};
+constexpr int AminoAcidTable::NumCodons;
+constexpr CodonId AminoAcidTable::InvalidCodon;
+constexpr std::array<char, AminoAcidTable::NumCodons> AminoAcidTable::Translation;
+
+CodonId AminoAcidTable::ToCodonId(const std::string& codon)
+{
+    if (codon.size() != 3) return InvalidCodon;
+    return ToCodonId(codon[0], codon[1], codon[2]);
+}
+
+std::string AminoAcidTable::ToCodon(const CodonId id)
+{
+    if (id >= NumCodons) return "";
+    return {BaseAt(id, 0), BaseAt(id, 1), BaseAt(id, 2)};
+}
 }
-}  //::PacBio::Juliet
\ No newline at end of file
+}  //::PacBio::Data
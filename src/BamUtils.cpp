@@ -53,28 +53,21 @@ std::unique_ptr<BAM::internal::IQuery> BamUtils::BamQuery(const std::string& fil
     return query;
 }
 
-std::vector<std::shared_ptr<Data::ArrayRead>> BamUtils::BamToArrayReads(const std::string& filePath,
-                                                                        int regionStart,
-                                                                        int regionEnd)
+bool BamUtils::IsArrayRead(const BAM::BamRecord& record, int regionStart, int regionEnd)
 {
-    std::vector<std::shared_ptr<Data::ArrayRead>> returnList;
     regionStart = std::max(regionStart - 1, 0);
     regionEnd = std::max(regionEnd - 1, 0);
+    if (record.Impl().IsSupplementaryAlignment()) return false;
+    if (!record.Impl().IsPrimaryAlignment()) return false;
+    return record.ReferenceStart() < regionEnd && record.ReferenceEnd() > regionStart;
+}
 
+std::vector<std::shared_ptr<Data::ArrayRead>> BamUtils::BamToArrayReads(const std::string& filePath,
+                                                                        int regionStart,
+                                                                        int regionEnd)
+{
     auto query = BamQuery(filePath);
-
-    int idx = 0;
-    // Iterate over all records and convert online
-    for (auto& record : *query) {
-        if (record.Impl().IsSupplementaryAlignment()) continue;
-        if (!record.Impl().IsPrimaryAlignment()) continue;
-        if (record.ReferenceStart() < regionEnd && record.ReferenceEnd() > regionStart) {
-            record.Clip(BAM::ClipType::CLIP_TO_REFERENCE, regionStart, regionEnd);
-            returnList.emplace_back(
-                std::make_shared<Data::BAMArrayRead>(Data::BAMArrayRead(record, idx++)));
-        }
-    }
-    return returnList;
+    return ToArrayReads(*query, regionStart, regionEnd);
 }
 }
 }  // ::PacBio::IO
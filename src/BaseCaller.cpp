@@ -0,0 +1,233 @@
+// Copyright (c) 2016-2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pacbio/data/FisherResult.h>
+#include <pacbio/data/NucleotideConversion.h>
+#include <pacbio/juliet/JulietSettings.h>
+
+#include <pacbio/juliet/BaseCaller.h>
+
+namespace PacBio {
+namespace Juliet {
+namespace {
+// Nucleotides and deletions that can be called, N is never called
+constexpr int NumCallableTags = 5;
+
+// Tag of the majority nucleotide or deletion, Ns are ignored
+int ArgMaxTag(const Data::MSAColumn& column)
+{
+    int argMax = 0;
+    for (int t = 1; t < NumCallableTags; ++t)
+        if (column[Data::TagToNucleotide(t)] > column[Data::TagToNucleotide(argMax)]) argMax = t;
+    return argMax;
+}
+
+// Coverage of nucleotides and deletions, Ns are neither called nor counted
+int CallableCoverage(const Data::MSAColumn& column) { return column.Coverage() - column['N']; }
+}
+
+BaseCaller::BaseCaller(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads,
+                       const ErrorEstimates& error, const JulietSettings& settings)
+    : error_(error)
+    , fisher_(2 * reads.size() + 1)
+    , fisherCache_(fisher_)
+    , targetConfig_(settings.TargetConfigUser)
+    , verbose_(settings.Verbose)
+    , debug_(settings.Debug)
+    , minimalPerc_(settings.MinimalPerc)
+{
+    // Only column counts are needed, stream reads into them without rows
+    for (const auto& read : reads)
+        msaByColumn_.AddRead(*read);
+    CallVariants();
+}
+
+int BaseCaller::CountNumberOfTests() const
+{
+    int numberOfTests = 0;
+    for (const auto& column : msaByColumn_) {
+        const int argMax = ArgMaxTag(column);
+        for (int t = 0; t < NumCallableTags; ++t)
+            if (t != argMax && column[Data::TagToNucleotide(t)] > 0) ++numberOfTests;
+        numberOfTests += column.Insertions().size();
+    }
+    return numberOfTests == 0 ? 1 : numberOfTests;
+}
+
+void BaseCaller::CallVariants()
+{
+    const int numberOfTests = CountNumberOfTests();
+
+    // Expected per-read rate of each tag under the null hypothesis that it
+    // has been generated by sequencing errors. ErrorEstimates::Insertion is
+    // not estimated and always 0, which would call every insertion; the
+    // deletion rate is used instead, assuming indels to be symmetric.
+    const double substitution = error_.Substitution;
+    const double deletion = error_.Deletion;
+    const double insertion = error_.Deletion;
+
+    std::vector<int> observed;
+    std::vector<double> expected;
+    std::vector<int> tags;
+    for (auto& column : msaByColumn_) {
+        const int coverage = CallableCoverage(column);
+        if (coverage == 0) continue;
+
+        // Test all but the majority nucleotide at once
+        const int argMax = ArgMaxTag(column);
+        observed.clear();
+        expected.clear();
+        tags.clear();
+        for (int t = 0; t < NumCallableTags; ++t) {
+            const int count = column[Data::TagToNucleotide(t)];
+            if (t == argMax || count == 0) continue;
+            tags.push_back(t);
+            observed.push_back(count);
+            expected.push_back(coverage * (t == 4 ? deletion : substitution));
+        }
+
+        // Bonferroni corrected p-value, reportable if significant and
+        // abundant enough
+        const auto Correct = [numberOfTests](double p) { return std::min(1.0, p * numberOfTests); };
+        const auto Reportable = [&](double p, int count) {
+            return p < alpha && 100.0 * count / coverage >= minimalPerc_;
+        };
+
+        Data::FisherResult fr;
+        fr.PValues.fill(1);
+        fr.ArgMax = argMax;
+        const auto pValues = fisherCache_.ExactTiss(coverage, observed, expected);
+        for (size_t j = 0; j < tags.size(); ++j) {
+            const double p = Correct(pValues[j]);
+            fr.PValues[tags[j]] = p;
+            if (Reportable(p, observed[j])) {
+                fr.Mask[tags[j]] = 1;
+                fr.Hit = true;
+            }
+        }
+        column.AddFisherResult(fr);
+
+        // Insertions are tested against the same coverage
+        if (column.Insertions().empty()) continue;
+        observed.clear();
+        expected.clear();
+        for (const auto& seq_count : column.Insertions()) {
+            observed.push_back(seq_count.second);
+            expected.push_back(coverage * insertion);
+        }
+        std::map<std::string, double> insertionPValues;
+        const auto insPValues = fisherCache_.ExactTiss(coverage, observed, expected);
+        bool insertionHit = false;
+        size_t j = 0;
+        for (const auto& seq_count : column.Insertions()) {
+            const double p = Correct(insPValues[j++]);
+            insertionPValues[seq_count.first] = p;
+            insertionHit |= Reportable(p, seq_count.second);
+        }
+        column.AddFisherResult(insertionPValues);
+
+        if (verbose_ && (fr.Hit || insertionHit)) column.InDels(std::cerr);
+    }
+    if (verbose_)
+        std::cerr << "Fisher cache hits: " << fisherCache_.Hits()
+                  << ", misses: " << fisherCache_.Misses() << std::endl;
+}
+
+JSON::Json BaseCaller::JSON() const
+{
+    using JSON::Json;
+    const bool hasReference = !targetConfig_.referenceSequence.empty();
+
+    std::vector<Json> positions;
+    for (const auto& column : msaByColumn_) {
+        const int coverage = CallableCoverage(column);
+        if (coverage == 0) continue;
+
+        // Unless in debug mode, report only significant and abundant ones
+        const auto Reportable = [&](double p, int count) {
+            return debug_ || (p < alpha && 100.0 * count / coverage >= minimalPerc_);
+        };
+
+        const int argMax = ArgMaxTag(column);
+        std::vector<Json> variants;
+        for (int t = 0; t < NumCallableTags; ++t) {
+            const char base = Data::TagToNucleotide(t);
+            if (t == argMax || column[base] == 0) continue;
+            if (!Reportable(column.PValue(base), column[base])) continue;
+            Json jVariant;
+            jVariant["nucleotide"] = std::string(1, base);
+            jVariant["frequency"] = 1.0 * column[base] / coverage;
+            jVariant["pValue"] = column.PValue(base);
+            variants.push_back(jVariant);
+        }
+
+        std::vector<Json> insertions;
+        for (const auto& seq_count : column.Insertions()) {
+            const double p = column.InsertionPValue(seq_count.first);
+            if (!Reportable(p, seq_count.second)) continue;
+            Json jInsertion;
+            jInsertion["sequence"] = seq_count.first;
+            jInsertion["frequency"] = 1.0 * seq_count.second / coverage;
+            jInsertion["pValue"] = p;
+            insertions.push_back(jInsertion);
+        }
+
+        if (variants.empty() && insertions.empty()) continue;
+
+        Json jPos;
+        jPos["ref_position"] = column.RefPos();
+        jPos["coverage"] = coverage;
+        if (hasReference)
+            jPos["wt"] = std::string(1, targetConfig_.referenceSequence.at(column.RefPos() - 1));
+        else
+            jPos["wt"] = std::string(1, Data::TagToNucleotide(argMax));
+        jPos["variant_nucleotides"] = variants;
+        jPos["insertions"] = insertions;
+        positions.push_back(jPos);
+    }
+
+    Json root;
+    root["variant_positions"] = positions;
+    return root;
+}
+}
+}  // ::PacBio::Juliet
@@ -7,9 +7,105 @@
 #include <pacbio/statistics/Fisher.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
 namespace PacBio {
 namespace Statistics {
+Fisher::Fisher(int maxTotal) : factln_(std::max(maxTotal, 1) + 1, 0.0)
+{
+    for (size_t n = 2; n < factln_.size(); ++n)
+        factln_[n] = lgamma(static_cast<double>(n + 1.0));
+}
+
 double Fisher::fisher_exact_tiss(int chi11, int chi12, int chi21, int chi22)
+{
+    static const Fisher engine(WrapperMaxTotal);
+    return engine.ExactTiss(chi11, chi12, chi21, chi22);
+}
+
+double Fisher::ExactTiss(int chi11, int chi12, int chi21, int chi22) const
+{
+    const double p = LongTail(chi11, chi12, chi21, chi22);
+    if (p >= 0) return p;
+    return TailSum(chi11, chi12, chi21, chi22);
+}
+
+std::vector<double> Fisher::ExactTiss(const int coverage, const std::vector<int>& observed,
+                                      const std::vector<double>& expected) const
+{
+    assert(observed.size() == expected.size());
+    const size_t numTables = observed.size();
+
+    // Row marginal of the observed counts is the same for all tables
+    const double lnCoverage = factln(coverage);
+
+    std::vector<std::array<int, 4>> tables(numTables);
+    std::vector<double> pValues(numTables);
+    std::vector<size_t> toSum;
+    toSum.reserve(numTables);
+    for (size_t i = 0; i < numTables; ++i) {
+        auto& t = tables[i];
+        t[0] = observed[i];
+        t[1] = coverage - observed[i];
+        t[2] = std::ceil(expected[i]);
+        t[3] = std::ceil(coverage - expected[i]);
+
+        pValues[i] = LongTail(t[0], t[1], t[2], t[3]);
+        if (pValues[i] >= 0) continue;
+
+        // Log probability of the observed table itself
+        pValues[i] = lnCoverage - factln(t[0]) - factln(t[1]) + binomialln(t[2] + t[3], t[2]) -
+                     binomialln(coverage + t[2] + t[3], t[0] + t[2]);
+        toSum.push_back(i);
+    }
+    for (const auto& i : toSum)
+        pValues[i] = exp(pValues[i]);
+    for (const auto& i : toSum) {
+        const auto& t = tables[i];
+        pValues[i] = TailSum(t[0], t[1], t[2], t[3], pValues[i]);
+    }
+    return pValues;
+}
+
+double Fisher::TailSum(int chi11, int chi12, int chi21, int chi22) const
+{
+    return TailSum(chi11, chi12, chi21, chi22, calc_hypergeom(chi11, chi12, chi21, chi22));
+}
+
+bool Fisher::IsSignificant(int chi11, int chi12, int chi21, int chi22, double threshold) const
+{
+    const double p = LongTail(chi11, chi12, chi21, chi22);
+    if (p >= 0) return p < threshold;
+    return TailSum(chi11, chi12, chi21, chi22, calc_hypergeom(chi11, chi12, chi21, chi22),
+                   threshold) < threshold;
+}
+
+double Fisher::LongTail(int chi11, int chi12, int chi21, int chi22)
+{
+    // Summing the tail costs one iteration per possible co-occurrence count
+    // above chi11. Long tails are approximated instead; the saddle point
+    // case, p-value of 1, is left to the summation.
+    const int max_co_occ = std::min(chi11 + chi12, chi11 + chi21);
+    if (max_co_occ - chi11 <= MaxTailTerms ||
+        factorInc(chi11, chi12, chi21, chi22) >= factorDec(chi11, chi12, chi21, chi22))
+        return -1;
+
+    // Near the mode the approximation is inaccurate, sum instead
+    const double n1 = chi11 + chi12;
+    const double m = chi11 + chi21;
+    const double total = n1 + chi21 + chi22;
+    const double mean = n1 * m / total;
+    const double variance = mean * (total - n1) * (total - m) / (total * (total - 1));
+    if (chi11 - mean < MinSaddlePointDeviations * sqrt(variance)) return -1;
+
+    return TailSaddlePoint(chi11, chi12, chi21, chi22);
+}
+
+double Fisher::TailSum(int chi11, int chi12, int chi21, int chi22, double base_p,
+                       double threshold) const
 {
     int co_occ = chi11;
 
@@ -32,10 +128,6 @@ double Fisher::fisher_exact_tiss(int chi11, int chi12, int chi21, int chi22)
     else
         max_co_occ = gene_b;
 
-    // Calculate the first hypergeometric value
-
-    double base_p = calc_hypergeom(chi11, chi12, chi21, chi22);
-
     // If co-occurrences at max possible, then this is our p-value,
     // Also if co-occurrences at min possible, this is our p-value.
 
@@ -50,6 +142,16 @@ double Fisher::fisher_exact_tiss(int chi11, int chi12, int chi21, int chi22)
         if (factor_inc < factor_dec) {
             // Loop up over co-occurrences
             do {
+                // Only a decision is requested, stop as soon as it is certain.
+                // The recurrence factor decreases with each step, thus the
+                // remaining tail is bounded by a geometric series.
+                if (threshold > 0) {
+                    if (base_p >= threshold) break;
+                    if (factor_inc < 1 &&
+                        base_p + curr_p * factor_inc / (1 - factor_inc) < threshold)
+                        break;
+                }
+
                 // Determine P-value for chi^2 matrix from recurrence factor
                 curr_p *= factor_inc;
 
@@ -76,6 +178,42 @@ double Fisher::fisher_exact_tiss(int chi11, int chi12, int chi21, int chi22)
     return base_p;
 }
 
+double Fisher::TailSaddlePoint(int chi11, int chi12, int chi21, int chi22)
+{
+    // Skovgaard's double saddlepoint approximation, with the second continuity
+    // correction, of P(X >= chi11 | X + Y = chi11 + chi21) with
+    // X ~ Bin(chi11 + chi12, p) and Y ~ Bin(chi21 + chi22, p).
+    // All saddlepoints are the observed proportions, thus closed form.
+    const double n1 = chi11 + chi12;
+    const double n2 = chi21 + chi22;
+    const double m = chi11 + chi21;
+    const double x = chi11 - 0.5;
+    const double y = m - x;
+    if (x <= 0 || x >= n1 || y <= 0 || y >= n2) return -1;
+
+    const double p0 = m / (n1 + n2);
+    const double p1 = x / n1;
+    const double p2 = y / n2;
+
+    // Signed root of the likelihood ratio statistic
+    const double deviance = 2 * (x * log(p1 / p0) + (n1 - x) * log((1 - p1) / (1 - p0)) +
+                                 y * log(p2 / p0) + (n2 - y) * log((1 - p2) / (1 - p0)));
+    const double s = log(p1 / (1 - p1)) - log(p2 / (1 - p2));
+    const double w = copysign(sqrt(std::max(deviance, 0.0)), s);
+
+    // Too close to the mean, the approximation is numerically unstable
+    if (fabs(w) < 1e-4) return -1;
+
+    const double v0 = (n1 + n2) * p0 * (1 - p0);
+    const double v1 = n1 * p1 * (1 - p1);
+    const double v2 = n2 * p2 * (1 - p2);
+    const double u = 2 * sinh(s / 2) * sqrt(v1 * v2 / v0);
+
+    const double phi = exp(-w * w / 2) / sqrt(2 * acos(-1.0));
+    const double p = 0.5 * erfc(w / sqrt(2.0)) - phi * (1 / w - 1 / u);
+    return std::min(std::max(p, 0.0), 1.0);
+}
+
 double Fisher::factorInc(int chi11, int chi12, int chi21, int chi22)
 {
     double factor_inc;
@@ -93,8 +231,8 @@ double Fisher::factorDec(int chi11, int chi12, int chi21, int chi22)
 
 double Fisher::gammln(double xx)
 {
-    static double cof[6] = {76.18009172947146,  -86.50532032941677,    24.01409824083091,
-                            -1.231739572450155, 0.1208650973866179e-2, -0.5395239384953e-5};
+    static const double cof[6] = {76.18009172947146,  -86.50532032941677,    24.01409824083091,
+                                  -1.231739572450155, 0.1208650973866179e-2, -0.5395239384953e-5};
     double x;
     double tmp;
     double ser;
@@ -112,34 +250,113 @@ double Fisher::gammln(double xx)
     return -tmp + log(2.50662827465 * ser);
 }
 
-double Fisher::factln(int n)
+double Fisher::factln(int n) const
 {
-    static double a[101];
-
-    if (n < 0) return 0.0;
     if (n <= 1) return 0.0;
-    if (n <= 100)
-        return a[n] ? a[n] : (a[n] = lgamma((double)(n + 1.0)));
+    if (n < static_cast<int>(factln_.size()))
+        return factln_[n];
     else
         return lgamma((double)(n + 1.0));
 }
 
-double Fisher::binomialln(int n, int k) { return (factln(n) - factln(k) - factln(n - k)); }
+double Fisher::binomialln(int n, int k) const { return (factln(n) - factln(k) - factln(n - k)); }
 
-double Fisher::calc_hypergeom(int chi11, int chi12, int chi21, int chi22)
+double Fisher::calc_hypergeom(int chi11, int chi12, int chi21, int chi22) const
 {
-    static double b1;
-    static double b2;
-    static double b3;
-    static int total;
+    const int total = chi11 + chi12 + chi21 + chi22;
 
-    total = chi11 + chi12 + chi21 + chi22;
-
-    b1 = binomialln(chi11 + chi12, chi11);
-    b2 = binomialln(chi21 + chi22, chi21);
-    b3 = binomialln(total, chi11 + chi21);
+    const double b1 = binomialln(chi11 + chi12, chi11);
+    const double b2 = binomialln(chi21 + chi22, chi21);
+    const double b3 = binomialln(total, chi11 + chi21);
 
     return exp(b1 + b2 - b3);
 }
+
+FisherCache::FisherCache(const Fisher& fisher, size_t capacity)
+    : fisher_(fisher), capacity_(capacity)
+{
+    pValues_.reserve(capacity_);
+}
+
+size_t FisherCache::TableHash::operator()(const Table& t) const
+{
+    size_t h = 0;
+    for (const auto& c : t)
+        h = h * 1000003 ^ std::hash<int>()(c);
+    return h;
+}
+
+std::vector<double> FisherCache::ExactTiss(const int coverage, const std::vector<int>& observed,
+                                           const std::vector<double>& expected)
+{
+    assert(observed.size() == expected.size());
+    const size_t numTables = observed.size();
+
+    std::vector<Table> tables(numTables);
+    std::vector<double> pValues(numTables);
+    std::vector<size_t> missing;
+    std::vector<int> missingObserved;
+    std::vector<double> missingExpected;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < numTables; ++i) {
+            tables[i] = {{observed[i], coverage - observed[i],
+                          static_cast<int>(std::ceil(expected[i])),
+                          static_cast<int>(std::ceil(coverage - expected[i]))}};
+            const auto it = pValues_.find(tables[i]);
+            if (it != pValues_.cend()) {
+                pValues[i] = it->second;
+            } else {
+                missing.push_back(i);
+                missingObserved.push_back(observed[i]);
+                missingExpected.push_back(expected[i]);
+            }
+        }
+    }
+    hits_ += numTables - missing.size();
+    misses_ += missing.size();
+    if (missing.empty()) return pValues;
+
+    // Compute outside of the lock
+    const auto computed = fisher_.ExactTiss(coverage, missingObserved, missingExpected);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pValues_.size() + missing.size() > capacity_) pValues_.clear();
+    for (size_t j = 0; j < missing.size(); ++j) {
+        pValues[missing[j]] = computed[j];
+        pValues_.emplace(tables[missing[j]], computed[j]);
+    }
+    return pValues;
+}
+
+bool FisherCache::IsSignificant(const int coverage, const int observed, const double expected,
+                                const double threshold)
+{
+    const Table table{{observed, coverage - observed, static_cast<int>(std::ceil(expected)),
+                       static_cast<int>(std::ceil(coverage - expected))}};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto p = pValues_.find(table);
+        if (p != pValues_.cend()) {
+            ++hits_;
+            return p->second < threshold;
+        }
+        const auto d = decisions_.find(table);
+        if (d != decisions_.cend() && d->second.first == threshold) {
+            ++hits_;
+            return d->second.second;
+        }
+    }
+    ++misses_;
+
+    // Decide outside of the lock
+    const bool significant =
+        fisher_.IsSignificant(table[0], table[1], table[2], table[3], threshold);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (decisions_.size() >= capacity_) decisions_.clear();
+    decisions_[table] = std::make_pair(threshold, significant);
+    return significant;
+}
 }
 }  //::PacBio::Statistics
\ No newline at end of file
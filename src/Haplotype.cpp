@@ -56,15 +56,37 @@ void Haplotype::SetFlagsByCodons()
     }
 }
 
-JSON::Json Haplotype::ToJson() const
+std::string Haplotype::FlagNames() const
+{
+    static const std::vector<std::pair<HaplotypeType, std::string>> names{
+        {HaplotypeType::WITH_GAP, "gap"},
+        {HaplotypeType::WITH_HETERODUPLEX, "heteroduplex"},
+        {HaplotypeType::PARTIAL, "partial"},
+        {HaplotypeType::LOW_COV, "low_coverage"},
+        {HaplotypeType::OFFTARGET, "off_target"}};
+    std::string result;
+    for (const auto& flag_name : names) {
+        if (!(flags_ & static_cast<int>(flag_name.first))) continue;
+        if (!result.empty()) result += ',';
+        result += flag_name.second;
+    }
+    return result;
+}
+
+JSON::Json Haplotype::ToJson(const std::vector<std::string>& readNames) const
 {
     using namespace JSON;
     Json root;
     root["name"] = name_;
-    root["reads_hard"] = readNames_.size();
+    root["reads_hard"] = NumReads();
+    if (countError_ > 0) root["reads_error"] = countError_;
     root["reads_soft"] = Size();
     root["frequency"] = frequency_;
-    root["read_names"] = readNames_;
+    std::vector<std::string> names;
+    names.reserve(readIds_.size());
+    for (const int id : readIds_)
+        names.push_back(readNames.at(id));
+    root["read_names"] = names;
     root["codons"] = codons_;
     return root;
 }
@@ -807,9 +807,10 @@ void JsonToHtml::Discovery(std::ostream& out, const JSON::Json& j, const TargetC
         out << "<li>Every table represents a gene.</li>" << std::endl;
         out << "<li>Positions are relative to the current gene.</li>" << std::endl;
     } else {
-        out << "<li>There is at maximum one table with an \"Unnamed ORF\"</li>" << std::endl;
-        out << "<li>Reading frame starts at the first position of the reference used for "
-               "alignment.</li>"
+        out << "<li>There is at maximum one table with an \"Unnamed ORF\" per reading frame</li>"
+            << std::endl;
+        out << "<li>Reading frames 1 to 3 start at the first three positions of the reference "
+               "used for alignment.</li>"
             << std::endl;
         out << "<li>The left side of the table shows major codons / AAs observed in this "
                "sample.</li>"
@@ -42,9 +42,9 @@
 #include <string>
 #include <vector>
 
+#include <pacbio/data/AminoAcidTable.h>
 #include <pacbio/data/ArrayRead.h>
 #include <pacbio/data/FisherResult.h>
-#include <pacbio/juliet/AminoAcidTable.h>
 
 #include <pacbio/data/MSA.h>
 
@@ -91,7 +91,81 @@ MSAByColumn::MSAByColumn(const MSAByRow& msaRows)
     }
 }
 
-MSAByRow::MSAByRow(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads)
+void MSAByColumn::AddRead(const ArrayRead& read)
+{
+    Extend(read.ReferenceStart(), read.ReferenceEnd());
+
+    // Absolute position of the next column, as in MSAByRow::AddRead
+    int pos = read.ReferenceStart();
+
+    std::string insertion;
+    auto CheckInsertion = [&insertion, &pos, this]() {
+        if (insertion.empty()) return;
+        // Insertions directly after the last column of a read are kept
+        Extend(pos, pos + 1);
+        (*this)[pos].IncInsertion(insertion);
+        insertion = "";
+    };
+    auto IncCounts = [&pos, this](const char c) {
+        switch (c) {
+            case 'A':
+            case 'C':
+            case 'G':
+            case 'T':
+            case '-':
+            case 'N':
+                (*this)[pos++].IncCounts(c);
+                break;
+            default:
+                throw std::runtime_error("Unexpected base " + std::string(1, c));
+        }
+    };
+
+    for (const auto& b : read.Bases()) {
+        switch (b.Cigar) {
+            case 'X':
+            case '=':
+                CheckInsertion();
+                IncCounts(b.MeetQVThresholds(qvThresholds_) ? b.Nucleotide : 'N');
+                break;
+            case 'D':
+                CheckInsertion();
+                IncCounts('-');
+                break;
+            case 'I':
+                insertion += b.Nucleotide;
+                break;
+            case 'P':
+            case 'S':
+                CheckInsertion();
+                break;
+            default:
+                throw std::runtime_error("Unexpected cigar " + std::to_string(b.Cigar));
+        }
+    }
+}
+
+void MSAByColumn::Extend(const int begin, const int end)
+{
+    if (begin >= end) return;
+    if (counts.empty()) {
+        beginPos_ = begin;
+        endPos_ = begin;
+    }
+    if (begin < beginPos_) {
+        MsaVec prefix;
+        prefix.reserve(beginPos_ - begin);
+        for (int i = begin; i < beginPos_; ++i)
+            prefix.emplace_back(i + 1);
+        counts.insert(counts.begin(), prefix.begin(), prefix.end());
+        beginPos_ = begin;
+    }
+    for (; endPos_ < end; ++endPos_)
+        counts.emplace_back(endPos_ + 1);
+}
+
+MSAByRow::MSAByRow(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads, const bool weighted)
+    : weighted_(weighted)
 {
     for (const auto& r : reads)
         UpdateBoundaries(*r);
@@ -99,40 +173,57 @@ MSAByRow::MSAByRow(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads)
     for (const auto& r : reads) {
         auto row = AddRead(*r);
         row.Read = r;
-        const auto x = std::make_shared<MSARow>(std::move(row));
-        nameToRow_[r->Name()] = x;
-        rows_.emplace_back(x);
+        rows_.emplace_back(std::make_shared<MSARow>(std::move(row)));
+        readNames_.emplace_back(r->Name());
     }
 
     ++beginPos_;
     ++endPos_;
 }
 
-MSAByRow::MSAByRow(const std::vector<Data::ArrayRead>& reads)
+MSAByRow::MSAByRow(const std::vector<Data::ArrayRead>& reads, const bool weighted)
+    : weighted_(weighted)
 {
     for (const auto& r : reads)
         UpdateBoundaries(r);
 
     for (const auto& r : reads) {
-        const auto x = std::make_shared<MSARow>(AddRead(r));
-        nameToRow_[r.Name()] = x;
-        rows_.emplace_back(x);
+        rows_.emplace_back(std::make_shared<MSARow>(AddRead(r)));
+        readNames_.emplace_back(r.Name());
     }
 
     ++beginPos_;
     ++endPos_;
 }
 
-std::map<std::string, int> MSAByRow::CodonsAt(const int i) const
+std::vector<CodonCounts> MSAByRow::CodonTensor() const
 {
-    std::map<std::string, int> codons;
+    const int size = endPos_ - beginPos_;
+    std::vector<CodonCounts> tensor(size, CodonCounts{});
 
-    std::string codon;
     for (const auto& row : rows_) {
-        if (row->CodingCodonAt(i, &codon)) ++codons[codon];
+        const auto& ids = row->CodonIds;
+        for (int i = 0; i < size; ++i)
+            if (ids[i] != AminoAcidTable::InvalidCodon) ++tensor[i][ids[i]];
     }
 
-    return codons;
+    return tensor;
+}
+
+std::vector<WeightedCodonCounts> MSAByRow::WeightedCodonTensor() const
+{
+    if (!weighted_) throw std::runtime_error("MSA has not been built with codon weights");
+
+    const int size = endPos_ - beginPos_;
+    std::vector<WeightedCodonCounts> tensor(size, WeightedCodonCounts{});
+
+    for (const auto& row : rows_) {
+        const auto& ids = row->CodonIds;
+        for (int i = 0; i < size; ++i)
+            if (ids[i] != AminoAcidTable::InvalidCodon) tensor[i][ids[i]] += row->CodonWeights[i];
+    }
+
+    return tensor;
 }
 
 void MSAByRow::UpdateBoundaries(const Data::ArrayRead& read)
@@ -148,6 +239,11 @@ MSARow MSAByRow::AddRead(const Data::ArrayRead& read)
     int pos = read.ReferenceStart() - beginPos_;
     assert(pos >= 0);
 
+    // Probability of each base to be correct. Missing QVs and QV 0, as
+    // stored for records without base qualities, are trusted
+    std::vector<float> probs;
+    if (weighted_) probs.assign(row.Bases.size(), 1);
+
     std::string insertion;
     auto CheckInsertion = [&insertion, &row, &pos]() {
         if (insertion.empty()) return;
@@ -160,6 +256,7 @@ MSARow MSAByRow::AddRead(const Data::ArrayRead& read)
             case 'X':
             case '=':
                 CheckInsertion();
+                if (weighted_ && b.QualQV && *b.QualQV > 0) probs[pos] = b.ProbTrue;
                 if (b.MeetQVThresholds(qvThresholds_))
                     row.Bases[pos++] = b.Nucleotide;
                 else
@@ -182,6 +279,20 @@ MSARow MSAByRow::AddRead(const Data::ArrayRead& read)
                 throw std::runtime_error("Unexpected cigar " + std::to_string(b.Cigar));
         }
     }
+
+    // Extract all codons once, CodonAt omits the first column
+    const int size = row.Bases.size();
+    row.CodonIds.assign(size, AminoAcidTable::InvalidCodon);
+    for (int i = 1; i + 2 < size; ++i)
+        row.CodonIds[i] =
+            AminoAcidTable::ToCodonId(row.Bases[i], row.Bases[i + 1], row.Bases[i + 2]);
+
+    // Branch-free over contiguous arrays, thus vectorized by the compiler
+    if (weighted_) {
+        row.CodonWeights.assign(size, 0);
+        for (int i = 0; i + 2 < size; ++i)
+            row.CodonWeights[i] = probs[i] * probs[i + 1] * probs[i + 2];
+    }
     return row;
 }
 
@@ -194,28 +305,12 @@ std::string MSARow::CodonAt(const int pos) const
     return codon;
 }
 
-bool MSARow::CodingCodonAt(const int winPos, std::string* codon) const
+CodonId MSARow::CodonIdAt(const int winPos) const
 {
-    using AAT = Juliet::AminoAcidTable;
-
-    const auto CodonContains = [this, &winPos](const char x) {
-        return (Bases.at(winPos + 0) == x || Bases.at(winPos + 1) == x ||
-                Bases.at(winPos + 2) == x);
-    };
-
     // Read does not cover codon
-    if (winPos + 2 >= static_cast<int>(Bases.size()) || winPos < 0) return false;
-    if (CodonContains(' ')) return false;
-
-    // Read has a deletion
-    if (CodonContains('-')) return false;
-
-    auto proposedCodon = CodonAt(winPos);
-    if (AAT::FromCodon.find(proposedCodon) == AAT::FromCodon.cend()) return false;
-
-    *codon = proposedCodon;
-
-    return true;
+    if (winPos < 0 || winPos >= static_cast<int>(CodonIds.size()))
+        return AminoAcidTable::InvalidCodon;
+    return CodonIds[winPos];
 }
 
 int MSAColumn::Coverage() const { return std::accumulate(counts_.cbegin(), counts_.cend(), 0); }
@@ -0,0 +1,101 @@
+// Copyright (c) 2017, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <algorithm>
+
+#include <pacbio/juliet/PatternSummary.h>
+
+namespace PacBio {
+namespace Juliet {
+
+void PatternSummary::Add(const std::string& pattern, const HaplotypeType flag, const int count,
+                         const int error)
+{
+    const auto it = slots_.find(pattern);
+    if (it != slots_.cend()) {
+        auto& c = counters_[it->second];
+        byCount_.erase(std::make_pair(c.count, it->second));
+        c.count += count;
+        c.error += error;
+        byCount_.emplace(c.count, it->second);
+    } else if (counters_.size() < capacity_) {
+        slots_.emplace(pattern, counters_.size());
+        byCount_.emplace(count, counters_.size());
+        counters_.push_back(Counter{pattern, flag, count, error});
+    } else {
+        // Replace the counter with the smallest count
+        const size_t slot = byCount_.cbegin()->second;
+        const int minCount = byCount_.cbegin()->first;
+        byCount_.erase(byCount_.cbegin());
+        slots_.erase(counters_[slot].pattern);
+        counters_[slot] = Counter{pattern, flag, minCount + count, minCount + error};
+        slots_.emplace(pattern, slot);
+        byCount_.emplace(minCount + count, slot);
+    }
+}
+
+void PatternSummary::Merge(const PatternSummary& other)
+{
+    std::vector<Counter> all;
+    for (const auto& c : counters_) {
+        const auto it = other.slots_.find(c.pattern);
+        if (it != other.slots_.cend())
+            all.push_back(Counter{c.pattern, c.flag, c.count + other.counters_[it->second].count,
+                                  c.error + other.counters_[it->second].error});
+        else
+            all.push_back(
+                Counter{c.pattern, c.flag, c.count + other.MinCount(), c.error + other.MinCount()});
+    }
+    for (const auto& c : other.counters_) {
+        if (slots_.find(c.pattern) == slots_.cend())
+            all.push_back(Counter{c.pattern, c.flag, c.count + MinCount(), c.error + MinCount()});
+    }
+    std::stable_sort(all.begin(), all.end(),
+                     [](const Counter& a, const Counter& b) { return a.count > b.count; });
+    if (all.size() > capacity_) all.resize(capacity_);
+
+    counters_.clear();
+    slots_.clear();
+    byCount_.clear();
+    for (auto& c : all) {
+        slots_.emplace(c.pattern, counters_.size());
+        byCount_.emplace(c.count, counters_.size());
+        counters_.emplace_back(std::move(c));
+    }
+}
+}
+}  //::PacBio::Juliet
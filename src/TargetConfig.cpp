@@ -35,9 +35,12 @@
 
 // Author: Armin Töpfer
 
+#include <algorithm>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <regex>
 #include <streambuf>
 #include <string>
@@ -88,6 +91,33 @@ TargetGene::TargetGene(const int begin, const int end, const std::string& name,
                        const std::vector<DRM>& drms, const std::vector<ExpectedMinor>& minors)
     : begin(begin), end(end), name(name), drms(drms), minors(minors)
 {
+    IndexDRMs();
+}
+
+void TargetGene::IndexDRMs()
+{
+    drmsByPosition_.clear();
+    for (size_t i = 0; i < drms.size(); ++i)
+        for (const auto& m : drms[i].positions)
+            drmsByPosition_[m.pos].emplace_back(i, m);
+}
+
+bool TargetGene::HasDRMs(int aaPos) const { return drmsByPosition_.count(aaPos) > 0; }
+
+std::string TargetGene::FindDRMs(const DMutation& curDRM) const
+{
+    std::string drmSummary;
+    const auto it = drmsByPosition_.find(curDRM.pos);
+    if (it == drmsByPosition_.cend()) return drmSummary;
+    // Entries are ordered by drm index, report each drm only once
+    size_t lastDrm = drms.size();
+    for (const auto& idx_mut : it->second) {
+        if (idx_mut.first == lastDrm || !(idx_mut.second == curDRM)) continue;
+        if (!drmSummary.empty()) drmSummary += " + ";
+        drmSummary += drms[idx_mut.first].name;
+        lastDrm = idx_mut.first;
+    }
+    return drmSummary;
 }
 
 JSON::Json TargetGene::ToJson() const
@@ -117,6 +147,37 @@ JSON::Json TargetGene::ToJson(const std::vector<TargetGene>& genes)
     return root;
 }
 
+TargetGeneIndex::TargetGeneIndex(const std::vector<TargetGene>& genes) : byBegin_(genes.size())
+{
+    std::iota(byBegin_.begin(), byBegin_.end(), 0);
+    std::stable_sort(byBegin_.begin(), byBegin_.end(),
+                     [&genes](size_t a, size_t b) { return genes[a].begin < genes[b].begin; });
+
+    int maxEnd = std::numeric_limits<int>::min();
+    for (const auto g : byBegin_) {
+        begins_.push_back(genes[g].begin);
+        ends_.push_back(genes[g].end);
+        maxEnd = std::max(maxEnd, genes[g].end);
+        maxEnds_.push_back(maxEnd);
+    }
+}
+
+std::vector<size_t> TargetGeneIndex::Overlapping(int begin, int end) const
+{
+    // Genes before first cannot reach begin, genes from last on start too late
+    const size_t first =
+        std::upper_bound(maxEnds_.cbegin(), maxEnds_.cend(), begin) - maxEnds_.cbegin();
+    const size_t last = std::lower_bound(begins_.cbegin(), begins_.cend(), end) - begins_.cbegin();
+
+    std::vector<size_t> genes;
+    for (size_t i = first; i < last; ++i) {
+        // Ends within [first, last) are not sorted, check each one
+        if (ends_[i] > begin) genes.push_back(byBegin_[i]);
+    }
+    std::sort(genes.begin(), genes.end());
+    return genes;
+}
+
 TargetConfig::TargetConfig(const std::string& input)
 {
     const auto inputString = DetermineConfigInput(input);
@@ -229,6 +290,7 @@ std::vector<TargetGene> TargetConfig::TargetGenesFromJson(const JSON::Json& root
             }
         }
         g.drms = std::move(drms);
+        g.IndexDRMs();
         std::vector<ExpectedMinor> minors;
         if (jGene.find("expectedminors") != jGene.cend()) {
             for (const auto& jMinor : jGene["expectedminors"]) {
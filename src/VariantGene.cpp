@@ -35,11 +35,13 @@
 
 // Author: Armin Töpfer
 
+#include <algorithm>
+
 #include <pacbio/juliet/VariantGene.h>
 
 namespace PacBio {
 namespace Juliet {
-JSON::Json VariantGene::ToJson() const
+JSON::Json VariantGene::ToJson(const std::function<std::vector<JSON::Json>(int)>& msaContext) const
 {
     using namespace JSON;
     Json root;
@@ -48,7 +50,7 @@ JSON::Json VariantGene::ToJson() const
     for (const auto& pos_variant : relPositionToVariant) {
         Json jVarPos;
         jVarPos["ref_position"] = pos_variant.first;
-        jVarPos["ref_codon"] = pos_variant.second->refCodon;
+        jVarPos["ref_codon"] = Data::AminoAcidTable::ToCodon(pos_variant.second->refCodon);
         jVarPos["coverage"] = pos_variant.second->coverage;
         jVarPos["ref_amino_acid"] = std::string(1, pos_variant.second->refAminoAcid);
 
@@ -62,18 +64,18 @@ JSON::Json VariantGene::ToJson() const
             if (aa_varCodon.second.empty()) continue;
             for (const auto& codon : aa_varCodon.second) {
                 Json jCodon;
-                jCodon["codon"] = codon.codon;
+                jCodon["codon"] = Data::AminoAcidTable::ToCodon(codon.codon);
                 jCodon["frequency"] = codon.frequency;
                 jCodon["pValue"] = codon.pValue;
                 jCodon["known_drm"] = codon.knownDRM;
-                jCodon["haplotype_hit"] = codon.haplotypeHit;
+                jCodon["haplotype_hit"] = pos_variant.second->HaplotypeHits(codon.codon);
                 jCodons.push_back(jCodon);
             }
             jVarAA["variant_codons"] = jCodons;
             jVarAAs.push_back(jVarAA);
         }
         jVarPos["variant_amino_acids"] = jVarAAs;
-        jVarPos["msa"] = pos_variant.second->msa;
+        jVarPos["msa"] = msaContext(pos_variant.second->absPos);
         positions.push_back(jVarPos);
     }
     if (!positions.empty()) root["variant_positions"] = positions;
@@ -81,19 +83,50 @@ JSON::Json VariantGene::ToJson() const
 }
 
 bool VariantGene::VariantPosition::IsVariant() const { return !aminoAcidToCodons.empty(); }
-bool VariantGene::VariantPosition::IsHit(const std::string& codon)
+bool VariantGene::VariantPosition::IsHit(const Data::CodonId codon) const
 {
-    if (codon == refCodon || codon == altRefCodon) {
-        return true;
-    }
-    for (const auto amino_varCodon : aminoAcidToCodons) {
-        for (const auto variant_codon : amino_varCodon.second) {
-            if (codon == variant_codon.codon) {
-                return true;
-            }
+    return codon < Data::AminoAcidTable::NumCodons && acceptedCodons_[codon];
+}
+
+void VariantGene::VariantPosition::IndexCodons()
+{
+    acceptedCodons_.reset();
+    hitRows_.fill(-1);
+    if (refCodon != Data::AminoAcidTable::InvalidCodon) acceptedCodons_.set(refCodon);
+    if (altRefCodon != Data::AminoAcidTable::InvalidCodon) acceptedCodons_.set(altRefCodon);
+    int numRows = 0;
+    for (const auto& amino_varCodon : aminoAcidToCodons) {
+        for (const auto& variant_codon : amino_varCodon.second) {
+            acceptedCodons_.set(variant_codon.codon);
+            hitRows_[variant_codon.codon] = numRows++;
         }
     }
-    return false;
+    ResetHits(0);
+}
+
+void VariantGene::VariantPosition::ResetHits(const size_t numHaplotypes)
+{
+    numHaplotypes_ = numHaplotypes;
+    wordsPerRow_ = (numHaplotypes + 63) / 64;
+    const size_t numRows = hitRows_.size() - std::count(hitRows_.cbegin(), hitRows_.cend(), -1);
+    hits_.assign(numRows * wordsPerRow_, 0);
+}
+
+bool VariantGene::VariantPosition::SetHit(const Data::CodonId codon, const size_t haplotype)
+{
+    if (codon >= Data::AminoAcidTable::NumCodons || hitRows_[codon] < 0) return false;
+    hits_[hitRows_[codon] * wordsPerRow_ + haplotype / 64] |= uint64_t(1) << (haplotype % 64);
+    return true;
+}
+
+std::vector<bool> VariantGene::VariantPosition::HaplotypeHits(const Data::CodonId codon) const
+{
+    std::vector<bool> hits(numHaplotypes_);
+    if (codon >= Data::AminoAcidTable::NumCodons || hitRows_[codon] < 0) return hits;
+    const uint64_t* row = &hits_[hitRows_[codon] * wordsPerRow_];
+    for (size_t h = 0; h < numHaplotypes_; ++h)
+        hits[h] = (row[h / 64] >> (h % 64)) & 1;
+    return hits;
 }
 }
 }  // ::PacBio::Juliet
\ No newline at end of file
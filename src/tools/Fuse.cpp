@@ -37,14 +37,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <exception>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <map>
 #include <memory>
 #include <numeric>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <vector>
 
 #include <pacbio/data/ArrayRead.h>
@@ -57,37 +64,105 @@
 namespace PacBio {
 namespace Fuse {
 
-Fuse::Fuse(const std::string& ccsInput, int minCoverage) : minCoverageRecommended_(minCoverage)
+Fuse::Fuse(const std::string& ccsInput, int minCoverage, size_t numThreads)
+    : minCoverageRecommended_(minCoverage)
 {
-    const auto arrayReads = FetchAlignedReads(ccsInput);
-    consensusSequence_ = CreateConsensus(arrayReads);
+    auto query = IO::BamUtils::BamQuery(ccsInput);
+    FuseRecords(*query, numThreads);
+}
+
+Fuse::Fuse(const std::vector<BAM::BamRecord>& records, int minCoverage, size_t numThreads)
+    : minCoverageRecommended_(minCoverage)
+{
+    FuseRecords(records, numThreads);
 }
+
+template <typename Records>
+void Fuse::FuseRecords(Records& records, size_t numThreads)
+{
+    struct Contig
+    {
+        std::string name;
+        Data::MSAByColumn msa;
+        int numReads = 0;
+    };
+
+    // Stream records into the column counts of their reference, one read at
+    // a time
+    std::map<int, Contig> contigs;
+    int idx = 0;
+    for (const auto& read : records) {
+        if (!read.Impl().IsMapped()) continue;
+        auto& contig = contigs[read.ReferenceId()];
+        if (contig.numReads++ == 0) contig.name = read.ReferenceName();
+        contig.msa.AddRead(Data::BAMArrayRead(read, idx++));
+    }
+    if (contigs.empty()) throw std::runtime_error("Empty input. Could not find records.");
+
+    std::vector<const Contig*> work;
+    for (const auto& id_contig : contigs)
+        work.push_back(&id_contig.second);
+
+    // Each thread takes the next contig, until all are done. Warnings and
+    // errors are kept per contig and reported in reference order.
+    std::vector<std::string> consensus(work.size());
+    std::vector<std::ostringstream> warnings(work.size());
+    std::vector<std::exception_ptr> errors(work.size());
+    std::atomic<size_t> next{0};
+    const auto Worker = [&]() {
+        for (size_t i = next++; i < work.size(); i = next++) {
+            try {
+                consensus[i] = CreateConsensus(work[i]->msa, work[i]->numReads, warnings[i]);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < std::max<size_t>(1, std::min(numThreads, work.size())); ++t)
+        threads.emplace_back(Worker);
+    for (auto& thread : threads)
+        thread.join();
+
+    // A single reference keeps the established name, multiple references
+    // are named after their source contig
+    const bool single = work.size() == 1;
+    for (size_t i = 0; i < work.size(); ++i) {
+        std::cerr << warnings[i].str();
+        if (errors[i]) std::rethrow_exception(errors[i]);
+        consensusSequences_.emplace_back(single ? "CONSENSUS" : work[i]->name,
+                                         std::move(consensus[i]));
+    }
+}
+
 Fuse::Fuse(const std::vector<Data::ArrayRead>& arrayReads)
 {
-    consensusSequence_ = CreateConsensus(arrayReads);
+    Data::MSAByColumn msa;
+    for (const auto& read : arrayReads)
+        msa.AddRead(read);
+    consensusSequences_.emplace_back("CONSENSUS",
+                                     CreateConsensus(msa, arrayReads.size(), std::cerr));
 }
 
-std::string Fuse::CreateConsensus(const std::vector<Data::ArrayRead>& arrayReads) const
+std::string Fuse::CreateConsensus(const Data::MSAByColumn& msa, int numReads,
+                                  std::ostream& warnings) const
 {
-    if (arrayReads.empty()) throw std::runtime_error("Empty input. Could not find records.");
-    Data::MSAByColumn msa(arrayReads);
+    if (numReads == 0) throw std::runtime_error("Empty input. Could not find records.");
 
-    int actualCoverage = arrayReads.size();
+    int actualCoverage = numReads;
     int minCoverage = minCoverageRecommended_;
     if (actualCoverage < minCoverageRecommended_) {
         minCoverage = 1;
-        std::cerr << "WARNING: Insufficient coverage of " << minCoverage
-                  << "! Operating in permissive mode. "
-                  << "Recommended coverage is >50x!" << std::endl;
+        warnings << "WARNING: Insufficient coverage of " << minCoverage
+                 << "! Operating in permissive mode. "
+                 << "Recommended coverage is >50x!" << std::endl;
     }
-    auto posInsCov = CollectInsertions(msa);
-    std::map<int, std::string> posIns;
-    while (!posInsCov.empty())
-        posIns.insert(FindInsertions(&posInsCov));
+    const auto posIns = SelectInsertions(CollectInsertions(msa));
 
     std::string consensus;
     for (const auto& c : msa) {
-        if (posIns.find(c.RefPos()) != posIns.cend()) consensus += posIns[c.RefPos()];
+        const auto ins = posIns.find(c.RefPos());
+        if (ins != posIns.cend()) consensus += ins->second;
         if (c.Coverage() >= minCoverage) {
             const auto maxBase = c.MaxBase();
             if (maxBase != '-' && maxBase != ' ') consensus += c.MaxBase();
@@ -118,38 +193,31 @@ std::map<int, std::pair<std::string, int>> Fuse::CollectInsertions(
     return posInsCov;
 }
 
-std::pair<int, std::string> Fuse::FindInsertions(
-    std::map<int, std::pair<std::string, int>>* posInsCov, int windowSize) const
-{
-    int argMax = -1;
-    int maxCov = -1;
-    std::string ins;
-    for (const auto& kv : *posInsCov) {
-        if (kv.second.second > maxCov) {
-            maxCov = kv.second.second;
-            argMax = kv.first;
-            ins = kv.second.first;
-        }
-    }
-
-    for (int i = std::max(0, argMax - windowSize); i < argMax + windowSize; ++i) {
-        auto it = posInsCov->find(i);
-        if (it != posInsCov->cend()) posInsCov->erase(it);
-    }
-    return std::make_pair(argMax, ins);
-}
-
-std::vector<Data::ArrayRead> Fuse::FetchAlignedReads(const std::string& ccsInput) const
+std::map<int, std::string> Fuse::SelectInsertions(
+    const std::map<int, std::pair<std::string, int>>& posInsCov, int windowSize)
 {
-    auto query = IO::BamUtils::BamQuery(ccsInput);
+    // Max-heap by coverage, smaller positions first on ties
+    std::vector<std::pair<int, int>> covNegPos;
+    covNegPos.reserve(posInsCov.size());
+    for (const auto& kv : posInsCov)
+        covNegPos.emplace_back(kv.second.second, -kv.first);
+    std::priority_queue<std::pair<int, int>> heap(std::less<std::pair<int, int>>(),
+                                                  std::move(covNegPos));
 
-    std::vector<Data::ArrayRead> reads;
-    int idx = 0;
-    for (const auto& read : *query) {
-        reads.emplace_back(Data::BAMArrayRead(read, idx++));
+    std::map<int, std::string> posIns;
+    std::set<int> selected;
+    while (!heap.empty()) {
+        const int pos = -heap.top().second;
+        heap.pop();
+        // Suppressed if within the window [s - windowSize, s + windowSize)
+        // of a selected position s. The smallest s with pos < s + windowSize
+        // is the only candidate to also satisfy s - windowSize <= pos.
+        const auto s = selected.upper_bound(pos - windowSize);
+        if (s != selected.cend() && *s - windowSize <= pos) continue;
+        selected.insert(pos);
+        posIns.emplace(pos, posInsCov.at(pos).first);
     }
-
-    return reads;
+    return posIns;
 }
 }
 }  // ::PacBio::Realign
\ No newline at end of file
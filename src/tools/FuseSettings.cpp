@@ -39,6 +39,7 @@
 
 #include <pacbio/Version.h>
 #include <pacbio/data/PlainOption.h>
+#include <pacbio/util/ThreadCount.h>
 #include <boost/algorithm/string.hpp>
 
 #include <pacbio/fuse/FuseSettings.h>
@@ -55,10 +56,18 @@ const PlainOption MinCoverage{
     "Minimal coverage to call a position.",
     CLI::Option::IntType(50)
 };
+const PlainOption NumThreads{
+    "num_threads",
+    { "num-threads", "j" },
+    "Number of Threads",
+    "Number of threads to use, 0 means autodetection. References are processed in parallel.",
+    CLI::Option::IntType(0)
+};
 }
 
 FuseSettings::FuseSettings(const PacBio::CLI::Results& options)
     : MinCoverage(options[OptionNames::MinCoverage])
+    , NumThreads(Util::ThreadCount(options[OptionNames::NumThreads]))
 {
     const size_t numArgs = options.PositionalArguments().size();
     if (numArgs != 2) throw std::runtime_error("Fuse needs one input and one output argument!");
@@ -97,7 +106,8 @@ PacBio::CLI::Interface FuseSettings::CreateCLI()
 
     i.AddOptions(
     {
-        OptionNames::MinCoverage
+        OptionNames::MinCoverage,
+        OptionNames::NumThreads
     });
 
     const std::string id = "minorseq.tasks.fuse";
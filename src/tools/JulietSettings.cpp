@@ -35,10 +35,12 @@
 
 // Author: Armin Töpfer
 
+#include <algorithm>
 #include <thread>
 
 #include <pacbio/Version.h>
 #include <pacbio/data/PlainOption.h>
+#include <pacbio/util/ThreadCount.h>
 #include <boost/algorithm/string.hpp>
 
 #include <pacbio/juliet/JulietSettings.h>
@@ -70,6 +72,13 @@ const PlainOption Phasing{
     "Phase variants and cluster haplotypes.",
     CLI::Option::BoolType()
 };
+const PlainOption Base{
+    "mode_base",
+    { "mode-base" },
+    "Call Nucleotide Variants",
+    "Call minor variants per nucleotide, deletion, and insertion, for non-coding targets.",
+    CLI::Option::BoolType()
+};
 const PlainOption Error{
     "mode_error",
     { "mode-error" },
@@ -130,6 +139,48 @@ const PlainOption MaximalPerc{
     "Report only variants whose percentage of the total population is less than this value. Lowering it helps to phase low frequency variants when the highest-frequency variant is different from the reference.",
     CLI::Option::FloatType(100)
 };
+const PlainOption WeightedCounts{
+    "weighted_counts",
+    { "weighted-counts" },
+    "Quality-Weighted Codon Counts",
+    "Each read contributes the product of its three base probabilities to a codon count, instead of one. Down-weights low QV evidence.",
+    CLI::Option::BoolType()
+};
+const PlainOption MergeSatellites{
+    "merge_satellites",
+    { "merge-satellites" },
+    "Merge Satellite Haplotypes",
+    "Merge haplotypes that differ from a larger haplotype in a single codon into it, if sequencing noise explains their abundance.",
+    CLI::Option::BoolType()
+};
+const PlainOption SoftAssign{
+    "soft_assign",
+    { "soft-assign" },
+    "Fractionally Assign Filtered Reads",
+    "Assign reads of filtered haplotypes, e.g., partial or with gaps, fractionally to the reported haplotypes by expectation-maximization of their proportions. Off-target reads are not assigned.",
+    CLI::Option::BoolType()
+};
+const PlainOption MaxPatterns{
+    "max_patterns",
+    { "max-patterns" },
+    "Maximum Number of Tracked Read Patterns",
+    "Bound the memory of the phased haplotypes by tracking at most this many read patterns in each of eight fixed slices of the reads, approximating counts of rare patterns. Aligned reads are still kept in memory. Counts of reported haplotypes may be overestimated by at most reads_error. 0 tracks all patterns exactly.",
+    CLI::Option::IntType(0)
+};
+const PlainOption HaplotypeBam{
+    "haplotype_bam",
+    { "haplotype-bam" },
+    "Haplotype Tagged BAM",
+    "Copy the input records to this BAM file. Phased reads are tagged with their haplotype name as HP, filtered reads with the reasons as HF. Requires --mode-phasing, not available with --max-patterns.",
+    CLI::Option::StringType("")
+};
+const PlainOption NumThreads{
+    "num_threads",
+    { "num-threads", "j" },
+    "Number of Threads",
+    "Number of threads to use, 0 means autodetection.",
+    CLI::Option::IntType(0)
+};
 const PlainOption Debug{
     "debug",
     { "debug" },
@@ -146,6 +197,11 @@ JulietSettings::JulietSettings(const PacBio::CLI::Results& options)
     , DRMOnly(options[OptionNames::DRMOnly])
     , Verbose(options[OptionNames::Verbose])
     , Debug(options[OptionNames::Debug])
+    , WeightedCounts(options[OptionNames::WeightedCounts])
+    , MergeSatellites(options[OptionNames::MergeSatellites])
+    , SoftAssign(options[OptionNames::SoftAssign])
+    , MaxPatterns(std::max(0, static_cast<int>(options[OptionNames::MaxPatterns])))
+    , NumThreads(Util::ThreadCount(options[OptionNames::NumThreads]))
     , Mode(AnalysisModeFromOptions(options))
     , SubstitutionRate(options[OptionNames::SubstitutionRate])
     , DeletionRate(options[OptionNames::DeletionRate])
@@ -154,6 +210,8 @@ JulietSettings::JulietSettings(const PacBio::CLI::Results& options)
 {
     const std::string targetConfigTC = options[OptionNames::TargetConfigTC];
     const std::string targetConfigCLI = options[OptionNames::TargetConfigCLI];
+    const std::string haplotypeBam = options[OptionNames::HaplotypeBam];
+    HaplotypeBam = haplotypeBam;
 
     if (targetConfigTC != "none")
         TargetConfigUser = targetConfigTC;
@@ -177,14 +235,17 @@ void JulietSettings::SplitRegion(const std::string& region, int* start, int* end
 AnalysisMode JulietSettings::AnalysisModeFromOptions(const PacBio::CLI::Results& options)
 {
     bool phasing = options[OptionNames::Phasing];
+    bool base = options[OptionNames::Base];
     bool error = options[OptionNames::Error];
-    int counter = phasing + error;
+    int counter = phasing + base + error;
     if (counter > 1) throw std::runtime_error("Overriding mode is mutually exclusive!");
 
-    if (!phasing && !error)
+    if (!phasing && !base && !error)
         return AnalysisMode::AMINO;
     else if (phasing)
         return AnalysisMode::PHASING;
+    else if (base)
+        return AnalysisMode::BASE;
     else if (error)
         return AnalysisMode::ERROR;
     else
@@ -213,6 +274,7 @@ PacBio::CLI::Interface JulietSettings::CreateCLI()
 
     i.AddOptions(
     {
+        OptionNames::NumThreads,
         OptionNames::Verbose,
         OptionNames::Debug,
         OptionNames::TargetConfigTC,
@@ -222,7 +284,13 @@ PacBio::CLI::Interface JulietSettings::CreateCLI()
     i.AddGroup("Configuration",
     {
         OptionNames::TargetConfigCLI,
-        OptionNames::Phasing
+        OptionNames::Phasing,
+        OptionNames::Base,
+        OptionNames::WeightedCounts,
+        OptionNames::MergeSatellites,
+        OptionNames::SoftAssign,
+        OptionNames::MaxPatterns,
+        OptionNames::HaplotypeBam
     });
 
     i.AddGroup("Restrictions",
@@ -242,6 +310,7 @@ PacBio::CLI::Interface JulietSettings::CreateCLI()
     const std::string id = "minorseq.tasks.juliet";
     Task tcTask(id);
     tcTask.AddOption(OptionNames::Phasing);
+    tcTask.AddOption(OptionNames::Base);
     tcTask.AddOption(OptionNames::Region);
     tcTask.AddOption(OptionNames::DRMOnly);
     tcTask.AddOption(OptionNames::TargetConfigTC);
@@ -251,6 +320,10 @@ PacBio::CLI::Interface JulietSettings::CreateCLI()
     tcTask.AddOption(OptionNames::Debug);
     tcTask.AddOption(OptionNames::MaximalPerc);
     tcTask.AddOption(OptionNames::MinimalPerc);
+    tcTask.AddOption(OptionNames::WeightedCounts);
+    tcTask.AddOption(OptionNames::MergeSatellites);
+    tcTask.AddOption(OptionNames::SoftAssign);
+    tcTask.AddOption(OptionNames::MaxPatterns);
 
     tcTask.InputFileTypes({
         {
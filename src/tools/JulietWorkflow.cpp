@@ -46,8 +46,11 @@
 #include <numeric>
 #include <vector>
 
+#include <pbbam/BamFile.h>
+#include <pbbam/BamHeader.h>
 #include <pbbam/BamReader.h>
 #include <pbbam/BamRecord.h>
+#include <pbbam/BamWriter.h>
 #include <pbbam/DataSet.h>
 
 #include <pbcopper/json/JSON.h>
@@ -57,6 +60,7 @@
 #include <pacbio/data/MSA.h>
 #include <pacbio/io/BamUtils.h>
 #include <pacbio/juliet/AminoAcidCaller.h>
+#include <pacbio/juliet/BaseCaller.h>
 #include <pacbio/juliet/JsonToHtml.h>
 #include <pacbio/juliet/JulietSettings.h>
 #include <pacbio/statistics/Fisher.h>
@@ -74,7 +78,8 @@ std::ostream& JulietWorkflow::LogCI(const std::string& prefix)
 
 void JulietWorkflow::Run(const JulietSettings& settings)
 {
-    if (settings.Mode == AnalysisMode::AMINO || settings.Mode == AnalysisMode::PHASING) {
+    if (settings.Mode == AnalysisMode::AMINO || settings.Mode == AnalysisMode::PHASING ||
+        settings.Mode == AnalysisMode::BASE) {
         AminoPhasing(settings);
     } else if (settings.Mode == AnalysisMode::ERROR) {
         Error(settings);
@@ -125,10 +130,21 @@ void JulietWorkflow::AminoPhasing(const JulietSettings& settings)
     // Missing input error handling
     if (bamInput.empty()) throw std::runtime_error("Missing input file!");
 
+    // The html report is amino acid centric
+    const bool baseMode = settings.Mode == AnalysisMode::BASE;
+    if (baseMode && !outputHtml.empty())
+        throw std::runtime_error("No html output available for nucleotide variants");
+
+    // Reads can only be tagged with their haplotype after phasing
+    if (!settings.HaplotypeBam.empty() && settings.Mode != AnalysisMode::PHASING)
+        throw std::runtime_error("Haplotype tagged BAM requires phasing");
+    if (!settings.HaplotypeBam.empty() && settings.MaxPatterns > 0)
+        throw std::runtime_error("Haplotype tagged BAM is not available with --max-patterns");
+
     // If no output type have been provided, output html and json
     if (outputHtml.empty() && outputJson.empty() && outputMsa.empty()) {
         const auto prefix = PacBio::Utility::FilePrefix(bamInput);
-        outputHtml = prefix + ".html";
+        if (!baseMode) outputHtml = prefix + ".html";
         outputJson = prefix + ".json";
     }
 
@@ -156,6 +172,39 @@ void JulietWorkflow::AminoPhasing(const JulietSettings& settings)
         error = ErrorEstimates(chemistry);
     }
 
+    // Store json
+    const auto StoreJson = [&outputJson](const JSON::Json& json) {
+        if (!outputJson.empty()) {
+            std::ofstream jsonStream(outputJson);
+            jsonStream << json.dump(2) << std::endl;
+        }
+    };
+
+    // Store msa
+    const auto StoreMsa = [&outputMsa](const Data::MSAByColumn& msaByColumn) {
+        if (!outputMsa.empty()) {
+            std::ofstream msaStream(outputMsa);
+            msaStream << "pos A C G T - N" << std::endl;
+            int pos = msaByColumn.BeginPos();
+            for (const auto& column : msaByColumn) {
+                ++pos;
+                msaStream << pos;
+                for (const auto& c : {'A', 'C', 'G', 'T', '-', 'N'})
+                    msaStream << " " << column[c];
+                msaStream << std::endl;
+            }
+            msaStream.close();
+        }
+    };
+
+    // Call nucleotide variants
+    if (baseMode) {
+        BaseCaller bc(sharedReads, error, settings);
+        StoreJson(bc.JSON());
+        StoreMsa(bc.msaByColumn_);
+        return;
+    }
+
     // Call variants
     AminoAcidCaller aac(sharedReads, error, settings);
 
@@ -164,10 +213,7 @@ void JulietWorkflow::AminoPhasing(const JulietSettings& settings)
 
     const auto json = aac.JSON();
 
-    if (!outputJson.empty()) {
-        std::ofstream jsonStream(outputJson);
-        jsonStream << json.dump(2) << std::endl;
-    }
+    StoreJson(json);
 
     if (!outputHtml.empty()) {
         std::ofstream htmlStream(outputHtml);
@@ -175,21 +221,55 @@ void JulietWorkflow::AminoPhasing(const JulietSettings& settings)
                          settings.CLI);
     }
 
-    // Store msa
-    if (!outputMsa.empty()) {
-        std::ofstream msaStream(outputMsa);
-        msaStream << "pos A C G T - N" << std::endl;
-        int pos = aac.msaByColumn_.BeginPos();
-        for (auto& column : aac.msaByColumn_) {
-            ++pos;
-            msaStream << pos;
-            for (const auto& c : {'A', 'C', 'G', 'T', '-', 'N'})
-                msaStream << " " << column[c];
-            msaStream << std::endl;
+    StoreMsa(aac.msaByColumn_);
+
+    if (!settings.HaplotypeBam.empty()) StoreHaplotypeBam(settings, bamInput, aac);
+}
+
+void JulietWorkflow::StoreHaplotypeBam(const JulietSettings& settings, const std::string& bamInput,
+                                       const AminoAcidCaller& aac)
+{
+    const auto readHaplotypes = aac.ReadHaplotypes();
+
+    const auto SetTag = [](BAM::BamRecord* record, const std::string& name,
+                           const std::string& value) {
+        auto& impl = record->Impl();
+        if (impl.HasTag(name))
+            impl.EditTag(name, BAM::Tag(value));
+        else
+            impl.AddTag(name, BAM::Tag(value));
+    };
+
+    // Open the output from the input header, to write a file even without
+    // records
+    const BAM::DataSet ds(bamInput);
+    const auto bamFiles = ds.BamFiles();
+    if (bamFiles.empty()) throw std::runtime_error("No BAM file in " + bamInput);
+    BAM::BamHeader header = bamFiles.front().Header().DeepCopy();
+    for (size_t i = 1; i < bamFiles.size(); ++i)
+        header += bamFiles[i].Header();
+    BAM::BamWriter out(settings.HaplotypeBam, header);
+
+    // Records are visited in the order of BamToArrayReads, thus each
+    // converted record is identified by its running index
+    auto query = IO::BamUtils::BamQuery(bamInput);
+    size_t readId = 0;
+    for (auto& record : *query) {
+        if (IO::BamUtils::IsArrayRead(record, settings.RegionStart, settings.RegionEnd)) {
+            if (readId >= readHaplotypes.size())
+                throw std::runtime_error("Input changed while writing haplotype tagged BAM");
+            const Haplotype* h = readHaplotypes[readId++];
+            if (h && h->Flags() == 0)
+                SetTag(&record, "HP", h->Name());
+            else if (h)
+                SetTag(&record, "HF", h->FlagNames());
         }
-        msaStream.close();
+        out.Write(record);
     }
+    if (readId != readHaplotypes.size())
+        throw std::runtime_error("Input changed while writing haplotype tagged BAM");
 }
+
 void JulietWorkflow::Error(const JulietSettings& settings)
 {
     for (const auto& inputFile : settings.InputFiles) {
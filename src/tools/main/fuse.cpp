@@ -62,16 +62,17 @@ static int Runner(const PacBio::CLI::Results& options)
     // Parse options
     FuseSettings settings(options);
 
-    Fuse fuse(settings.InputFile, settings.MinCoverage);
+    Fuse fuse(settings.InputFile, settings.MinCoverage, settings.NumThreads);
 
     auto outputFile = settings.OutputFile;
     const bool isXml = Utility::FileExtension(outputFile) == "xml";
     if (isXml) boost::ireplace_all(outputFile, ".referenceset.xml", ".fasta");
 
     std::ofstream outputFastaStream(outputFile);
-    const auto consensus = fuse.ConsensusSequence();
-    outputFastaStream << ">CONSENSUS" << std::endl;
-    outputFastaStream << consensus << std::endl;
+    for (const auto& name_consensus : fuse.ConsensusSequences()) {
+        outputFastaStream << ">" << name_consensus.first << std::endl;
+        outputFastaStream << name_consensus.second << std::endl;
+    }
 
 #if 0
     // Write Dataset
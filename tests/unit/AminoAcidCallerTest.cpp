@@ -0,0 +1,361 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/data/MSA.h>
+#include <pacbio/juliet/AminoAcidCaller.h>
+#include <pacbio/juliet/ErrorEstimates.h>
+#include <pacbio/juliet/Haplotype.h>
+#include <pacbio/juliet/JulietSettings.h>
+
+#include "TestArrayRead.h"
+
+using namespace PacBio;          // NOLINT
+using namespace PacBio::Juliet;  // NOLINT
+
+namespace {
+
+// 1000 reads of a 30 bp coding reference, with
+// - GAA instead of GCT at codon 4 in every third read,
+// - ACT instead of GCT at codon 7 in every fifth read, and
+// - N in codon 7 in every 47th read.
+// Reads are identified by their index, e.g., "read/7" is the eighth read.
+std::vector<std::shared_ptr<Data::ArrayRead>> PhasingReads()
+{
+    const std::string ref = "ATGGCTAAAGCTGGTAAAGCTGGTAAAGCT";
+    std::vector<std::shared_ptr<Data::ArrayRead>> reads;
+    for (int i = 0; i < 1000; ++i) {
+        std::string seq = ref;
+        if (i % 3 == 0) seq.replace(9, 3, "GAA");
+        if (i % 5 == 0) seq.replace(18, 3, "ACT");
+        if (i % 47 == 0) seq[19] = 'N';
+        reads.emplace_back(
+            std::make_shared<Data::TestArrayRead>(i, 0, std::string(seq.size(), '='), seq));
+    }
+    return reads;
+}
+
+// Key of the haplotype of a read of PhasingReads
+int PhasingKey(const int readId)
+{
+    return (readId % 3 == 0) + 2 * (readId % 5 == 0) + 4 * (readId % 47 == 0);
+}
+
+std::unique_ptr<AminoAcidCaller> Phase(const std::vector<std::shared_ptr<Data::ArrayRead>>& reads,
+                                       const size_t numThreads)
+{
+    JulietSettings settings;
+    settings.Mode = AnalysisMode::PHASING;
+    settings.NumThreads = numThreads;
+    std::unique_ptr<AminoAcidCaller> aac(
+        new AminoAcidCaller(reads, ErrorEstimates(0.005, 0.005), settings));
+    aac->PhaseVariants();
+    return aac;
+}
+
+void ExpectEqualHaplotypes(const std::vector<Haplotype>& expected,
+                           const std::vector<Haplotype>& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].Name(), actual[i].Name());
+        EXPECT_EQ(expected[i].ConcatCodons(), actual[i].ConcatCodons());
+        EXPECT_EQ(expected[i].Size(), actual[i].Size());
+        EXPECT_EQ(expected[i].Flags(), actual[i].Flags());
+        EXPECT_EQ(expected[i].ReadIds(), actual[i].ReadIds());
+    }
+}
+
+TEST(AminoAcidCallerTest, SoftCountsOfInformativeReads)
+{
+    // Each soft item is explained by a single generator
+    const auto soft = AminoAcidCaller::SoftCounts({10, 30}, {1, 0, 0, 1, 1, 0}, {5, 7, 2});
+    ASSERT_EQ(2u, soft.size());
+    EXPECT_NEAR(7, soft[0], 1e-9);
+    EXPECT_NEAR(7, soft[1], 1e-9);
+}
+
+TEST(AminoAcidCallerTest, SoftCountsConvergeOnKnownMixture)
+{
+    // 40 soft reads of generator A and 40 ambiguous ones. At the fixed point
+    // p_A = (20 + 40 + 40 p_A) / 120, thus p_A = 3/4 and A is assigned all
+    // of its own and 3/4 of the ambiguous reads.
+    const auto soft = AminoAcidCaller::SoftCounts({20, 20}, {1, 0, 1, 1}, {40, 40});
+    ASSERT_EQ(2u, soft.size());
+    EXPECT_NEAR(70, soft[0], 1e-4);
+    EXPECT_NEAR(10, soft[1], 1e-4);
+}
+
+TEST(AminoAcidCallerTest, SoftCountsAreAFixedPoint)
+{
+    const std::vector<double> hard{50, 30, 20};
+    // clang-format off
+    const std::vector<double> likelihoods{
+        1,    0.1, 0.01,
+        0.2,  1,   0.2,
+        0.05, 0.5, 1,
+        1,    1,   1,
+        0.3,  0.3, 1};
+    // clang-format on
+    const std::vector<double> readCounts{10, 25, 15, 40, 8};
+    const auto soft = AminoAcidCaller::SoftCounts(hard, likelihoods, readCounts);
+    ASSERT_EQ(3u, soft.size());
+
+    // All soft reads are assigned
+    EXPECT_NEAR(98, std::accumulate(soft.cbegin(), soft.cend(), 0.0), 1e-9);
+
+    // Another E-step with the final proportions does not change the counts
+    std::vector<double> proportions(3);
+    for (size_t g = 0; g < 3; ++g)
+        proportions[g] = (hard[g] + soft[g]) / (100 + 98);
+    for (size_t g = 0; g < 3; ++g) {
+        double expected = 0;
+        for (size_t f = 0; f < readCounts.size(); ++f) {
+            double sum = 0;
+            for (size_t h = 0; h < 3; ++h)
+                sum += proportions[h] * likelihoods[f * 3 + h];
+            expected += readCounts[f] * proportions[g] * likelihoods[f * 3 + g] / sum;
+        }
+        EXPECT_NEAR(expected, soft[g], 1e-3);
+    }
+}
+
+TEST(AminoAcidCallerTest, SoftCountsWithoutHardCounts)
+{
+    const auto soft = AminoAcidCaller::SoftCounts({0, 0}, {1, 0, 1, 1}, {30, 10});
+    ASSERT_EQ(2u, soft.size());
+    EXPECT_NEAR(40, soft[0], 1e-3);
+    EXPECT_NEAR(0, soft[1], 1e-3);
+}
+
+TEST(AminoAcidCallerTest, WeightedCodonTensorIsRounded)
+{
+    std::vector<std::shared_ptr<Data::ArrayRead>> withQVs;
+    std::vector<std::shared_ptr<Data::ArrayRead>> withoutQVs;
+    for (int i = 0; i < 100; ++i) {
+        withQVs.emplace_back(std::make_shared<Data::TestArrayRead>(i, 0, "======", "ACGTAC", 20));
+        withoutQVs.emplace_back(std::make_shared<Data::TestArrayRead>(i, 0, "======", "ACGTAC", 0));
+    }
+    const auto cgt = Data::AminoAcidTable::ToCodonId('C', 'G', 'T');
+
+    // 100 * 0.99^3 = 97.03
+    const Data::MSAByRow weighted(withQVs, true);
+    EXPECT_EQ(97, AminoAcidCaller::CodonTensor(weighted, true)[1][cgt]);
+    EXPECT_EQ(100, AminoAcidCaller::CodonTensor(weighted, false)[1][cgt]);
+
+    // Without base qualities, weighted counts equal plain counts
+    const Data::MSAByRow trusted(withoutQVs, true);
+    EXPECT_EQ(AminoAcidCaller::CodonTensor(trusted, false),
+              AminoAcidCaller::CodonTensor(trusted, true));
+    EXPECT_EQ(100, AminoAcidCaller::CodonTensor(trusted, true)[1][cgt]);
+}
+
+TEST(AminoAcidCallerTest, PhasingIsIndependentOfThreads)
+{
+    const auto reads = PhasingReads();
+    const auto serial = Phase(reads, 1);
+    // Two variant codons, four combinations
+    ASSERT_EQ(4u, serial->Haplotypes().size());
+    EXPECT_EQ(522, serial->Haplotypes().front().Size());
+    EXPECT_FALSE(serial->FilteredHaplotypes().empty());
+
+    for (const size_t numThreads : {2, 4, 7}) {
+        const auto threaded = Phase(reads, numThreads);
+        ExpectEqualHaplotypes(serial->Haplotypes(), threaded->Haplotypes());
+        ExpectEqualHaplotypes(serial->FilteredHaplotypes(), threaded->FilteredHaplotypes());
+    }
+}
+
+TEST(AminoAcidCallerTest, ReadIdsResolveToNames)
+{
+    const auto reads = PhasingReads();
+    const auto aac = Phase(reads, 4);
+
+    // Every read is phased once, all reads of a haplotype share its codons
+    std::vector<int> numHaplotypes(reads.size(), 0);
+    for (const auto* haplotypes : {&aac->Haplotypes(), &aac->FilteredHaplotypes()}) {
+        for (const auto& h : *haplotypes) {
+            ASSERT_FALSE(h.ReadIds().empty());
+            const int key = PhasingKey(h.ReadIds().front());
+            for (const int id : h.ReadIds()) {
+                ++numHaplotypes.at(id);
+                EXPECT_EQ(key, PhasingKey(id));
+                EXPECT_EQ(reads[id]->Name(), aac->ReadNames().at(id));
+            }
+            // Read ids stay in row order across merged slices
+            EXPECT_TRUE(std::is_sorted(h.ReadIds().cbegin(), h.ReadIds().cend()));
+        }
+    }
+    EXPECT_EQ(std::vector<int>(reads.size(), 1), numHaplotypes);
+
+    // The JSON output lists the names of the read ids
+    const auto json = aac->JSON();
+    ASSERT_EQ(aac->Haplotypes().size(), json["haplotypes"].size());
+    for (size_t i = 0; i < aac->Haplotypes().size(); ++i) {
+        std::vector<std::string> names;
+        for (const int id : aac->Haplotypes()[i].ReadIds())
+            names.push_back(reads[id]->Name());
+        EXPECT_EQ(names, json["haplotypes"][i]["read_names"].get<std::vector<std::string>>());
+    }
+}
+
+TEST(AminoAcidCallerTest, ReadHaplotypesForTags)
+{
+    const auto reads = PhasingReads();
+    const auto aac = Phase(reads, 4);
+    const auto readHaplotypes = aac->ReadHaplotypes();
+    ASSERT_EQ(reads.size(), readHaplotypes.size());
+    for (size_t id = 0; id < reads.size(); ++id) {
+        const Haplotype* h = readHaplotypes[id];
+        ASSERT_NE(nullptr, h);
+        const auto& ids = h->ReadIds();
+        EXPECT_NE(ids.cend(), std::find(ids.cbegin(), ids.cend(), static_cast<int>(id)));
+        // Reported reads are tagged by name, filtered reads by flags
+        if (h->Flags() == 0) {
+            EXPECT_FALSE(h->Name().empty());
+            EXPECT_EQ("", h->FlagNames());
+        } else {
+            EXPECT_FALSE(h->FlagNames().empty());
+        }
+    }
+    // Read 0 has an N in its second variant codon, shared only by read 705
+    EXPECT_EQ("heteroduplex,low_coverage,off_target", readHaplotypes[0]->FlagNames());
+    EXPECT_EQ("A", readHaplotypes[1]->Name());
+}
+
+TEST(AminoAcidCallerTest, HaplotypeFlagNames)
+{
+    EXPECT_EQ("", Haplotype(0, {"GCT", "GAA"}, HaplotypeType::REPORT).FlagNames());
+
+    Haplotype h(0, {"G-T", "  T", "GNA"}, HaplotypeType::OFFTARGET);
+    EXPECT_EQ("gap,heteroduplex,partial,off_target", h.FlagNames());
+    h.AddFlag(HaplotypeType::LOW_COV);
+    EXPECT_EQ("gap,heteroduplex,partial,low_coverage,off_target", h.FlagNames());
+}
+
+TEST(AminoAcidCallerTest, MergeSatellitesDoesNotChain)
+{
+    JulietSettings settings;
+    AminoAcidCaller aac(PhasingReads(), ErrorEstimates(0.05, 0.05), settings);
+
+    // B is a satellite of A, C is a satellite of B and two codons away from A
+    std::vector<std::shared_ptr<Haplotype>> haplotypes;
+    std::vector<std::vector<Data::CodonId>> signatures;
+    const auto Add = [&](std::vector<std::string> codons, const int numReads) {
+        std::vector<Data::CodonId> ids;
+        for (const auto& codon : codons)
+            ids.push_back(Data::AminoAcidTable::ToCodonId(codon));
+        signatures.push_back(ids);
+        auto h = std::make_shared<Haplotype>(std::vector<int>(), std::move(codons),
+                                             HaplotypeType::REPORT);
+        h->AddUntrackedReads(numReads, 0);
+        haplotypes.push_back(h);
+    };
+    Add({"GCT", "GCT"}, 2000);
+    Add({"GAT", "GCT"}, 20);
+    Add({"GAT", "GAT"}, 1);
+
+    EXPECT_EQ(1, aac.MergeSatellites(&haplotypes, signatures));
+    ASSERT_EQ(2u, haplotypes.size());
+    EXPECT_EQ(2020, haplotypes[0]->NumReads());
+    EXPECT_EQ("GCTGCT", haplotypes[0]->ConcatCodons());
+    EXPECT_EQ(1, haplotypes[1]->NumReads());
+    EXPECT_EQ("GATGAT", haplotypes[1]->ConcatCodons());
+}
+
+TEST(AminoAcidCallerTest, CodonProbabilities)
+{
+    using AAT = Data::AminoAcidTable;
+    const ErrorEstimates error(0.003, 0.0003);
+    const auto probabilities = AminoAcidCaller::CodonProbabilities(error);
+
+    // Each codon turns into any codon, unless a base is deleted
+    for (int a = 0; a < AAT::NumCodons; ++a) {
+        const double sum = std::accumulate(probabilities.cbegin() + a * AAT::NumCodons,
+                                           probabilities.cbegin() + (a + 1) * AAT::NumCodons, 0.0);
+        EXPECT_LE(sum, 1.0);
+        EXPECT_NEAR(std::pow(1 - 0.0003, 3), sum, 1e-12);
+    }
+
+    // Match or substitution of each of the three bases
+    const auto Probability = [&](const std::string& a, const std::string& b) {
+        return probabilities[AAT::ToCodonId(a) * AAT::NumCodons + AAT::ToCodonId(b)];
+    };
+    const double match = error.Match;
+    const double sub = error.Substitution;
+    EXPECT_DOUBLE_EQ(match * match * match, Probability("GCT", "GCT"));
+    EXPECT_DOUBLE_EQ(match * sub * match, Probability("GCT", "GAT"));
+    EXPECT_DOUBLE_EQ(sub * match * sub, Probability("ACT", "GCA"));
+    EXPECT_DOUBLE_EQ(sub * sub * sub, Probability("GCT", "TGA"));
+    EXPECT_DOUBLE_EQ(Probability("GCT", "GAT"), Probability("GAT", "GCT"));
+}
+
+TEST(AminoAcidCallerTest, UnnamedOrfsOfAllThreeFrames)
+{
+    // Without target config, each forward frame of the window is a gene. The
+    // variant codons of PhasingReads lie in frame 1, shifted by one and two
+    // bases they also alter codons of frames 2 and 3.
+    JulietSettings settings;
+    AminoAcidCaller aac(PhasingReads(), ErrorEstimates(0.005, 0.005), settings);
+    const auto json = aac.JSON();
+    ASSERT_EQ(3u, json["genes"].size());
+
+    const auto RefCodons = [&json](const size_t frame) {
+        std::vector<std::string> codons;
+        for (const auto& v : json["genes"][frame]["variant_positions"])
+            codons.push_back(std::to_string(v["ref_position"].get<int>()) + ":" +
+                             v["ref_codon"].get<std::string>());
+        return codons;
+    };
+    EXPECT_EQ("Unnamed ORF, frame 1", json["genes"][0]["name"]);
+    EXPECT_THAT(RefCodons(0), ::testing::ElementsAre("4:GCT", "7:GCT"));
+    EXPECT_EQ("Unnamed ORF, frame 2", json["genes"][1]["name"]);
+    EXPECT_THAT(RefCodons(1), ::testing::ElementsAre("4:CTG", "6:AAG"));
+    EXPECT_EQ("Unnamed ORF, frame 3", json["genes"][2]["name"]);
+    EXPECT_THAT(RefCodons(2), ::testing::ElementsAre("3:AGC", "4:TGG", "6:AGC"));
+}
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pbbam/BamRecord.h>
+#include <pbbam/BamRecordImpl.h>
+#include <pbbam/Cigar.h>
+
+#include <pacbio/io/BamUtils.h>
+
+using namespace PacBio;  // NOLINT
+
+namespace {
+
+BAM::BamRecord Record(const std::string& name, const int position, const bool primary = true,
+                      const bool supplementary = false)
+{
+    BAM::BamRecordImpl impl;
+    impl.Name(name);
+    impl.SetSequenceAndQualities("ACGTACGTAC", "IIIIIIIIII");
+    impl.CigarData(BAM::Cigar("10="));
+    impl.ReferenceId(position < 0 ? -1 : 0);
+    impl.Position(position);
+    impl.SetMapped(position >= 0);
+    impl.SetPrimaryAlignment(primary);
+    impl.SetSupplementaryAlignment(supplementary);
+    return BAM::BamRecord(std::move(impl));
+}
+
+std::vector<BAM::BamRecord> Records()
+{
+    return {Record("movie/0/ccs", 10),
+            Record("movie/1/ccs", 20, false),
+            Record("movie/2/ccs", 30, true, true),
+            Record("movie/3/ccs", -1),
+            Record("movie/4/ccs", 500),
+            Record("movie/5/ccs", 40)};
+}
+
+// The haplotype tagged BAM pairs the records accepted by IsArrayRead, in
+// order, with the read ids of the converted reads
+void ExpectPaired(const int regionStart, const int regionEnd,
+                  const std::vector<std::string>& expectedNames)
+{
+    auto records = Records();
+    std::vector<std::string> accepted;
+    for (const auto& record : records)
+        if (IO::BamUtils::IsArrayRead(record, regionStart, regionEnd))
+            accepted.push_back(record.FullName());
+
+    const auto reads = IO::BamUtils::ToArrayReads(records, regionStart, regionEnd);
+    std::vector<std::string> converted;
+    for (const auto& read : reads)
+        converted.push_back(read->Name());
+
+    EXPECT_EQ(expectedNames, accepted);
+    EXPECT_EQ(accepted, converted);
+}
+
+TEST(BamUtilsTest, ConvertsRecordsAcceptedByIsArrayRead)
+{
+    // Secondary, supplementary, and unmapped records are skipped
+    ExpectPaired(0, std::numeric_limits<int>::max(), {"movie/0/ccs", "movie/4/ccs", "movie/5/ccs"});
+}
+
+TEST(BamUtilsTest, ConvertsRecordsOverlappingRegion)
+{
+    // 1-based region 1-100 excludes the record at 500
+    ExpectPaired(1, 100, {"movie/0/ccs", "movie/5/ccs"});
+}
+}
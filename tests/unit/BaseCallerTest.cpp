@@ -0,0 +1,168 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/juliet/BaseCaller.h>
+#include <pacbio/juliet/ErrorEstimates.h>
+#include <pacbio/juliet/JulietSettings.h>
+
+#include "TestArrayRead.h"
+
+using namespace PacBio;          // NOLINT
+using namespace PacBio::Juliet;  // NOLINT
+
+namespace {
+
+// 1000 reads of the 20 bp reference ACGTACGTACGTACGTACGT, with
+// - G instead of C at position 6 in 100 reads,
+// - N at position 11 in 900 reads, and A instead of G in 20 of the others,
+// - insertion TT before position 17 in 50 reads,
+// - insertion A before position 17 in 20 reads.
+std::vector<std::shared_ptr<Data::ArrayRead>> Reads()
+{
+    const std::string ref = "ACGTACGTACGTACGTACGT";
+    std::vector<std::shared_ptr<Data::ArrayRead>> reads;
+    for (int i = 0; i < 1000; ++i) {
+        std::string seq = ref;
+        if (i < 100) seq[5] = 'G';
+        if (i < 900)
+            seq[10] = 'N';
+        else if (i < 920)
+            seq[10] = 'A';
+        std::string cigar(seq.size(), '=');
+        if (i >= 100 && i < 150) {
+            seq.insert(16, "TT");
+            cigar.insert(16, "II");
+        } else if (i >= 150 && i < 170) {
+            seq.insert(16, "A");
+            cigar.insert(16, "I");
+        }
+        reads.emplace_back(std::make_shared<Data::TestArrayRead>(i, 0, cigar, seq));
+    }
+    return reads;
+}
+
+JSON::Json Position(const JSON::Json& root, int refPos)
+{
+    for (const auto& p : root["variant_positions"])
+        if (p["ref_position"] == refPos) return p;
+    return JSON::Json();
+}
+
+TEST(BaseCallerTest, CallsSubstitutionsAndInsertions)
+{
+    JulietSettings settings;
+    settings.MinimalPerc = 5;
+    const BaseCaller bc(Reads(), ErrorEstimates(0.003, 0.0003), settings);
+    const auto json = bc.JSON();
+    ASSERT_EQ(3u, json["variant_positions"].size());
+
+    const auto sub = Position(json, 6);
+    ASSERT_FALSE(sub.is_null());
+    EXPECT_EQ("C", sub["wt"]);
+    EXPECT_EQ(1000, sub["coverage"]);
+    ASSERT_EQ(1u, sub["variant_nucleotides"].size());
+    EXPECT_EQ("G", sub["variant_nucleotides"][0]["nucleotide"]);
+    EXPECT_DOUBLE_EQ(0.1, sub["variant_nucleotides"][0]["frequency"].get<double>());
+    EXPECT_TRUE(sub["insertions"].empty());
+
+    // Insertion A is significant, but below --min-perc
+    const auto ins = Position(json, 17);
+    ASSERT_FALSE(ins.is_null());
+    ASSERT_EQ(1u, ins["insertions"].size());
+    EXPECT_EQ("TT", ins["insertions"][0]["sequence"]);
+    EXPECT_DOUBLE_EQ(0.05, ins["insertions"][0]["frequency"].get<double>());
+}
+
+TEST(BaseCallerTest, IgnoresNs)
+{
+    JulietSettings settings;
+    settings.MinimalPerc = 5;
+    const BaseCaller bc(Reads(), ErrorEstimates(0.003, 0.0003), settings);
+
+    // 20 of 100 callable bases, not 20 of 1000
+    const auto pos = Position(bc.JSON(), 11);
+    ASSERT_FALSE(pos.is_null());
+    EXPECT_EQ(100, pos["coverage"]);
+    EXPECT_EQ("G", pos["wt"]);
+    ASSERT_EQ(1u, pos["variant_nucleotides"].size());
+    EXPECT_EQ("A", pos["variant_nucleotides"][0]["nucleotide"]);
+    EXPECT_DOUBLE_EQ(0.2, pos["variant_nucleotides"][0]["frequency"].get<double>());
+}
+
+TEST(BaseCallerTest, DebugReportsRealInsertionPValues)
+{
+    JulietSettings settings;
+    settings.MinimalPerc = 5;
+    settings.Debug = true;
+    const BaseCaller bc(Reads(), ErrorEstimates(0.003, 0.0003), settings);
+
+    const auto ins = Position(bc.JSON(), 17);
+    ASSERT_FALSE(ins.is_null());
+    ASSERT_EQ(2u, ins["insertions"].size());
+    // Ordered by sequence
+    EXPECT_EQ("A", ins["insertions"][0]["sequence"]);
+    EXPECT_DOUBLE_EQ(0.02, ins["insertions"][0]["frequency"].get<double>());
+    EXPECT_LT(ins["insertions"][0]["pValue"].get<double>(), 0.01);
+    EXPECT_EQ("TT", ins["insertions"][1]["sequence"]);
+    EXPECT_LT(ins["insertions"][1]["pValue"].get<double>(),
+              ins["insertions"][0]["pValue"].get<double>());
+}
+
+TEST(BaseCallerTest, InsertionsAreTestedAgainstDeletionRate)
+{
+    JulietSettings settings;
+    settings.Debug = true;
+    const auto InsertionPValue = [&settings](const ErrorEstimates& error) {
+        const BaseCaller bc(Reads(), error, settings);
+        return Position(bc.JSON(), 17)["insertions"][0]["pValue"].get<double>();
+    };
+
+    // 20 insertions A in 1000 reads are noise if indels occur at 3%,
+    // regardless of the substitution rate
+    const double p = InsertionPValue(ErrorEstimates(0.003, 0.0003));
+    EXPECT_LT(p, 0.01);
+    EXPECT_DOUBLE_EQ(p, InsertionPValue(ErrorEstimates(0.3, 0.0003)));
+    EXPECT_GT(InsertionPValue(ErrorEstimates(0.003, 0.03)), 0.01);
+}
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/juliet/CodonSignature.h>
+
+using namespace PacBio::Juliet;  // NOLINT
+using PacBio::Data::AminoAcidTable;
+using PacBio::Data::CodonId;
+
+namespace {
+
+int NaiveDistance(const std::vector<CodonId>& a, const std::vector<CodonId>& b)
+{
+    int distance = 0;
+    for (size_t j = 0; j < a.size(); ++j)
+        distance += a[j] != b[j];
+    return distance;
+}
+
+int Distance(const std::vector<CodonId>& a, const std::vector<CodonId>& b, const int maxDistance)
+{
+    const auto pa = PackSignature(a);
+    const auto pb = PackSignature(b);
+    return HammingDistance(pa.data(), pb.data(), pa.size(), maxDistance);
+}
+
+TEST(CodonSignatureTest, PacksEightCodonsPerWord)
+{
+    const std::vector<CodonId> ids{1, 2, 3, 4, 5, 6, 7, 8, 63, AminoAcidTable::InvalidCodon};
+    const auto words = PackSignature(ids);
+    ASSERT_EQ(2u, words.size());
+    EXPECT_EQ(0x0807060504030201ULL, words[0]);
+    // Unused bytes of the last word are zero
+    EXPECT_EQ(0x403FULL, words[1]);
+    EXPECT_TRUE(PackSignature({}).empty());
+}
+
+TEST(CodonSignatureTest, DistanceOfInvalidCodons)
+{
+    const CodonId invalid = AminoAcidTable::InvalidCodon;
+    // Invalid codons are equal to each other, but differ from any codon,
+    // including 0 and 63, whose xor with InvalidCodon uses all seven bits
+    EXPECT_EQ(0, Distance({invalid, 5, invalid}, {invalid, 5, invalid}, 3));
+    EXPECT_EQ(1, Distance({invalid}, {0}, 3));
+    EXPECT_EQ(1, Distance({invalid}, {63}, 3));
+    EXPECT_EQ(3, Distance({0, invalid, 63}, {invalid, 63, invalid}, 3));
+}
+
+TEST(CodonSignatureTest, DistanceOfLengthsNotMultipleOfEight)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> codon(0, AminoAcidTable::InvalidCodon);
+    std::bernoulli_distribution same(0.7);
+    for (size_t length = 1; length <= 25; ++length) {
+        for (int i = 0; i < 50; ++i) {
+            std::vector<CodonId> a(length);
+            std::vector<CodonId> b(length);
+            for (size_t j = 0; j < length; ++j) {
+                a[j] = codon(rng);
+                b[j] = same(rng) ? a[j] : codon(rng);
+            }
+            EXPECT_EQ(NaiveDistance(a, b), Distance(a, b, length));
+        }
+    }
+}
+
+TEST(CodonSignatureTest, DistanceStopsAfterMaxDistance)
+{
+    // 16 differences in two words, the second word is skipped
+    const std::vector<CodonId> a(16, 1);
+    const std::vector<CodonId> b(16, 2);
+    EXPECT_EQ(16, Distance(a, b, 16));
+    EXPECT_EQ(8, Distance(a, b, 1));
+    // Result exceeds maxDistance, whenever the true distance does
+    EXPECT_GT(Distance(a, b, 8), 8);
+}
+}
@@ -35,6 +35,9 @@
 
 // Author: Lance Hepler
 
+#include <cmath>
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -72,4 +75,132 @@ TEST(FisherTest, EquivalentWithR)
         EXPECT_NEAR(pValuesFromR.at(i), Fisher::fisher_exact_tiss(i, 1000, 10, 1000),
                     pValuesFromR.at(i) / 1e5);
 }
+
+TEST(FisherTest, PrecomputedTableEquivalentWithWrapper)
+{
+    const Fisher fisher(2100);
+    for (int i = 0; i < 100; ++i)
+        EXPECT_DOUBLE_EQ(Fisher::fisher_exact_tiss(i, 1000, 10, 1000),
+                         fisher.ExactTiss(i, 1000, 10, 1000));
+}
+
+TEST(FisherTest, SaddlePointEquivalentWithTailSum)
+{
+    // Tables with tails longer than Fisher::MaxTailTerms
+    const Fisher fisher(200100);
+    for (const int coverage : {20000, 100000}) {
+        for (const int expected : {1001, 2000, coverage / 10}) {
+            for (const int excess : {10, 50, 100, 200, 500, 1000, 2000}) {
+                const int observed = expected + excess;
+                const double sum =
+                    fisher.TailSum(observed, coverage - observed, expected, coverage - expected);
+                const double approx = Fisher::TailSaddlePoint(observed, coverage - observed,
+                                                              expected, coverage - expected);
+                // Both underflow in the extreme tail
+                if (sum < 1e-300) continue;
+                EXPECT_NEAR(sum, approx, sum * 1e-4);
+            }
+        }
+    }
+}
+
+TEST(FisherTest, SwitchesToSaddlePointForLongTails)
+{
+    const Fisher fisher(200100);
+    // Tail of 51 terms, summed exactly
+    EXPECT_DOUBLE_EQ(fisher.TailSum(150, 99850, 100, 99900),
+                     fisher.ExactTiss(150, 99850, 100, 99900));
+    // Tail of 2100 terms, approximated
+    EXPECT_DOUBLE_EQ(Fisher::TailSaddlePoint(150, 99850, 2000, 98000),
+                     fisher.ExactTiss(150, 99850, 2000, 98000));
+}
+
+TEST(FisherTest, SumsLongTailsNearTheMean)
+{
+    const Fisher fisher(200100);
+    // Tail of 66666 terms, 0.01 standard deviations above the mean, where the
+    // saddlepoint approximation is off by 1e-3
+    EXPECT_DOUBLE_EQ(fisher.TailSum(66668, 133332, 66666, 133334),
+                     fisher.ExactTiss(66668, 133332, 66666, 133334));
+    EXPECT_NEAR(0.49866, fisher.ExactTiss(66668, 133332, 66666, 133334), 1e-5);
+    // Tail of 1100 terms, 2.5 standard deviations above the mean
+    EXPECT_DOUBLE_EQ(fisher.TailSum(1220, 98780, 1100, 98900),
+                     fisher.ExactTiss(1220, 98780, 1100, 98900));
+}
+
+TEST(FisherTest, BatchEquivalentWithSingleTables)
+{
+    const Fisher fisher(200100);
+    for (const int coverage : {1000, 100000}) {
+        const std::vector<int> observed{0, 1, 5, 20, coverage / 100, coverage / 10, coverage / 2};
+        const std::vector<double> expected{
+            0.3, 2.5, 1.1, 20, coverage / 50.0, 1.0, coverage / 20.0};
+        const auto pValues = fisher.ExactTiss(coverage, observed, expected);
+        ASSERT_EQ(observed.size(), pValues.size());
+        for (size_t i = 0; i < observed.size(); ++i)
+            EXPECT_NEAR(fisher.ExactTiss(observed[i], coverage - observed[i],
+                                         std::ceil(expected[i]), std::ceil(coverage - expected[i])),
+                        pValues[i], pValues[i] * 1e-12);
+    }
+}
+
+TEST(FisherTest, CacheAnswersRepeatedTables)
+{
+    const Fisher fisher(4100);
+    FisherCache cache(fisher, 4);
+    const std::vector<int> observed{5, 20, 40};
+    const std::vector<double> expected{1.1, 2.5, 3.7};
+    const auto pValues = fisher.ExactTiss(2000, observed, expected);
+
+    EXPECT_EQ(pValues, cache.ExactTiss(2000, observed, expected));
+    EXPECT_EQ(0u, cache.Hits());
+    EXPECT_EQ(3u, cache.Misses());
+
+    EXPECT_EQ(pValues, cache.ExactTiss(2000, observed, expected));
+    EXPECT_EQ(3u, cache.Hits());
+    EXPECT_EQ(3u, cache.Misses());
+
+    // Exceeding the capacity flushes the cache
+    cache.ExactTiss(1000, observed, expected);
+    EXPECT_EQ(pValues, cache.ExactTiss(2000, observed, expected));
+    EXPECT_EQ(3u, cache.Hits());
+    EXPECT_EQ(9u, cache.Misses());
+}
+
+TEST(FisherTest, CacheAnswersRepeatedDecisions)
+{
+    const Fisher fisher(4100);
+    FisherCache cache(fisher);
+    const double pValue = fisher.ExactTiss(20, 1980, 3, 1998);
+
+    EXPECT_TRUE(cache.IsSignificant(2000, 20, 2.5, pValue * 2));
+    EXPECT_FALSE(cache.IsSignificant(2000, 20, 2.5, pValue / 2));
+    EXPECT_EQ(0u, cache.Hits());
+    EXPECT_EQ(2u, cache.Misses());
+
+    // Same threshold is answered from the decision
+    EXPECT_FALSE(cache.IsSignificant(2000, 20, 2.5, pValue / 2));
+    EXPECT_EQ(1u, cache.Hits());
+    EXPECT_EQ(2u, cache.Misses());
+
+    // Any threshold is answered from a cached p-value
+    cache.ExactTiss(2000, {20}, {2.5});
+    EXPECT_TRUE(cache.IsSignificant(2000, 20, 2.5, pValue * 2));
+    EXPECT_FALSE(cache.IsSignificant(2000, 20, 2.5, pValue));
+    EXPECT_EQ(3u, cache.Hits());
+    EXPECT_EQ(3u, cache.Misses());
+}
+
+TEST(FisherTest, DecisionEquivalentWithPValue)
+{
+    const Fisher fisher(200100);
+    for (const double threshold : {0.05, 1e-4, 1e-8, 1e-20}) {
+        for (int i = 0; i < 100; ++i)
+            EXPECT_EQ(fisher.ExactTiss(i, 1000, 10, 1000) < threshold,
+                      fisher.IsSignificant(i, 1000, 10, 1000, threshold));
+        for (int i = 100; i < 400; i += 3)
+            EXPECT_EQ(fisher.ExactTiss(i, 100000 - i, 100, 99900) < threshold,
+                      fisher.IsSignificant(i, 100000 - i, 100, 99900, threshold));
+    }
+}
 }
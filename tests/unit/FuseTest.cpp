@@ -0,0 +1,191 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pbbam/BamHeader.h>
+#include <pbbam/BamRecord.h>
+#include <pbbam/BamRecordImpl.h>
+#include <pbbam/Cigar.h>
+#include <pbbam/SequenceInfo.h>
+
+#include <pacbio/fuse/Fuse.h>
+
+using namespace PacBio::Fuse;  // NOLINT
+
+namespace {
+
+using PosInsCov = std::map<int, std::pair<std::string, int>>;
+
+PosInsCov Candidates(const std::map<int, int>& posCov)
+{
+    PosInsCov posInsCov;
+    for (const auto& kv : posCov)
+        posInsCov[kv.first] = std::make_pair("ins" + std::to_string(kv.first), kv.second);
+    return posInsCov;
+}
+
+std::vector<int> Positions(const std::map<int, std::string>& posIns)
+{
+    std::vector<int> positions;
+    for (const auto& kv : posIns)
+        positions.push_back(kv.first);
+    return positions;
+}
+
+// Repeatedly pick the candidate with the highest coverage, the smallest
+// position on ties, and erase all candidates of its window
+std::map<int, std::string> NaiveSelectInsertions(PosInsCov posInsCov, const int windowSize)
+{
+    std::map<int, std::string> posIns;
+    while (!posInsCov.empty()) {
+        auto best = posInsCov.cbegin();
+        for (auto it = posInsCov.cbegin(); it != posInsCov.cend(); ++it)
+            if (it->second.second > best->second.second) best = it;
+        const int s = best->first;
+        posIns.emplace(s, best->second.first);
+        posInsCov.erase(posInsCov.lower_bound(s - windowSize),
+                        posInsCov.lower_bound(s + windowSize));
+    }
+    return posIns;
+}
+
+TEST(FuseTest, SelectInsertionsBreaksTiesBySmallerPosition)
+{
+    EXPECT_THAT(Positions(Fuse::SelectInsertions(Candidates({{10, 5}, {14, 5}}), 5)),
+                ::testing::ElementsAre(10));
+    EXPECT_THAT(Positions(Fuse::SelectInsertions(Candidates({{10, 5}, {14, 6}}), 5)),
+                ::testing::ElementsAre(14));
+    EXPECT_EQ("ins14", Fuse::SelectInsertions(Candidates({{10, 5}, {14, 6}}), 5).at(14));
+}
+
+TEST(FuseTest, SelectInsertionsWindowIsHalfOpen)
+{
+    // s - windowSize and s + windowSize - 1 are suppressed
+    EXPECT_THAT(Positions(Fuse::SelectInsertions(Candidates({{45, 5}, {50, 10}, {54, 5}}), 5)),
+                ::testing::ElementsAre(50));
+    // s - windowSize - 1 and s + windowSize are not
+    EXPECT_THAT(Positions(Fuse::SelectInsertions(Candidates({{44, 5}, {50, 10}, {55, 5}}), 5)),
+                ::testing::ElementsAre(44, 50, 55));
+}
+
+TEST(FuseTest, SelectInsertionsOnlySelectedSuppress)
+{
+    // Overlapping windows, 4 is suppressed by 0 and cannot suppress 8
+    EXPECT_THAT(
+        Positions(Fuse::SelectInsertions(Candidates({{0, 10}, {4, 9}, {8, 8}, {12, 7}}), 5)),
+        ::testing::ElementsAre(0, 8));
+    EXPECT_THAT(
+        Positions(Fuse::SelectInsertions(Candidates({{0, 7}, {4, 8}, {8, 9}, {12, 10}}), 5)),
+        ::testing::ElementsAre(4, 12));
+}
+
+TEST(FuseTest, SelectInsertionsEqualsNaive)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pos(1, 300);
+    std::uniform_int_distribution<int> cov(1, 10);
+    for (int trial = 0; trial < 100; ++trial) {
+        std::map<int, int> posCov;
+        for (int i = 0; i < 40; ++i)
+            posCov[pos(rng)] = cov(rng);
+        const auto candidates = Candidates(posCov);
+        for (const int windowSize : {1, 5, 20})
+            EXPECT_EQ(NaiveSelectInsertions(candidates, windowSize),
+                      Fuse::SelectInsertions(candidates, windowSize));
+    }
+}
+
+// numReads mapped copies of seq on reference refId of header
+void AddRecords(std::vector<PacBio::BAM::BamRecord>* records, const PacBio::BAM::BamHeader& header,
+                const int refId, const std::string& seq, const int numReads)
+{
+    for (int i = 0; i < numReads; ++i) {
+        PacBio::BAM::BamRecord record(header);
+        auto& impl = record.Impl();
+        impl.Name("movie/" + std::to_string(records->size()) + "/ccs");
+        impl.SetSequenceAndQualities(seq, std::string(seq.size(), 'I'));
+        impl.CigarData(PacBio::BAM::Cigar(std::to_string(seq.size()) + "="));
+        impl.ReferenceId(refId);
+        impl.Position(0);
+        impl.SetMapped(true);
+        records->push_back(std::move(record));
+    }
+}
+
+PacBio::BAM::BamHeader TwoReferences()
+{
+    PacBio::BAM::BamHeader header;
+    header.AddSequence(PacBio::BAM::SequenceInfo("refA", "10"));
+    header.AddSequence(PacBio::BAM::SequenceInfo("refB", "10"));
+    return header;
+}
+
+TEST(FuseTest, OneConsensusPerReference)
+{
+    const auto header = TwoReferences();
+    std::vector<PacBio::BAM::BamRecord> records;
+    AddRecords(&records, header, 1, "TTGGCCAATT", 60);
+    AddRecords(&records, header, 0, "ACGTACGTAC", 60);
+    AddRecords(&records, header, 1, "TTGGCCAATT", 5);
+
+    for (const size_t numThreads : {1, 2, 4}) {
+        const Fuse fuse(records, 50, numThreads);
+        EXPECT_THAT(fuse.ConsensusSequences(),
+                    ::testing::ElementsAre(std::make_pair("refA", "ACGTACGTAC"),
+                                           std::make_pair("refB", "TTGGCCAATT")));
+    }
+}
+
+TEST(FuseTest, SingleReferenceIsNamedConsensus)
+{
+    const auto header = TwoReferences();
+    std::vector<PacBio::BAM::BamRecord> records;
+    AddRecords(&records, header, 1, "TTGGCCAATT", 60);
+
+    const Fuse fuse(records, 50);
+    EXPECT_THAT(fuse.ConsensusSequences(),
+                ::testing::ElementsAre(std::make_pair("CONSENSUS", "TTGGCCAATT")));
+}
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/juliet/Haplotype.h>
+#include <pacbio/juliet/HaplotypeIndex.h>
+
+using namespace PacBio::Juliet;  // NOLINT
+using PacBio::Data::AminoAcidTable;
+using PacBio::Data::CodonId;
+
+namespace {
+
+std::vector<CodonId> Ids(const std::vector<std::string>& codons)
+{
+    std::vector<CodonId> ids;
+    for (const auto& codon : codons)
+        ids.push_back(AminoAcidTable::ToCodonId(codon));
+    return ids;
+}
+
+uint64_t Hash(const std::vector<CodonId>& ids)
+{
+    uint64_t hash = HaplotypeIndex::HashSeed;
+    for (const auto id : ids)
+        hash = HaplotypeIndex::Hash(hash, id);
+    return hash;
+}
+
+// Collapse rows of codons into haplotypes as in AminoAcidCaller, with the
+// hash reduced by hashMask to force collisions
+Observations Collapse(const std::vector<std::vector<std::string>>& rows, const uint64_t hashMask)
+{
+    Observations obs;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        const auto ids = Ids(rows[r]);
+        const uint64_t hash = Hash(ids) & hashMask;
+        const int idx =
+            obs.Find(hash, ids, [&](size_t j) -> const std::string& { return rows[r][j]; });
+        if (idx != HaplotypeIndex::Empty)
+            obs.haplotypes[idx]->AddReadId(r);
+        else
+            obs.Add(hash, ids, std::make_shared<Haplotype>(r, rows[r], HaplotypeType::REPORT));
+    }
+    return obs;
+}
+
+TEST(HaplotypeIndexTest, FindsHaplotypesWithCollidingHashes)
+{
+    // All haplotypes share one hash, growing the table beyond its initial
+    // 64 slots
+    Observations obs;
+    std::vector<std::vector<CodonId>> signatures;
+    for (CodonId a = 0; a < 10; ++a) {
+        for (CodonId b = 0; b < 10; ++b) {
+            const std::vector<CodonId> ids{a, b};
+            std::vector<std::string> codons{AminoAcidTable::ToCodon(a), AminoAcidTable::ToCodon(b)};
+            obs.Add(7, ids, std::make_shared<Haplotype>(0, codons, HaplotypeType::REPORT));
+            signatures.push_back(ids);
+        }
+    }
+    const auto NoCodon = [](size_t) -> std::string { return ""; };
+    for (size_t i = 0; i < signatures.size(); ++i)
+        EXPECT_EQ(static_cast<int>(i), obs.Find(7, signatures[i], NoCodon));
+    EXPECT_EQ(-1, obs.Find(7, {10, 10}, NoCodon));
+    EXPECT_EQ(-1, obs.Find(8, {1, 1}, NoCodon));
+}
+
+TEST(HaplotypeIndexTest, TellsInvalidCodonsApartByBases)
+{
+    // Gaps and Ns have no codon id, thus equal ids and hashes
+    const std::vector<std::vector<std::string>> rows{
+        {"G-T", "GCT"}, {"GNT", "GCT"}, {"G-T", "GCT"}, {"GCT", "GCT"}, {"GNT", "GCT"}};
+    ASSERT_EQ(Ids(rows[0]), Ids(rows[1]));
+    ASSERT_EQ(AminoAcidTable::InvalidCodon, Ids(rows[0]).front());
+
+    const auto obs = Collapse(rows, ~uint64_t(0));
+    ASSERT_EQ(3u, obs.haplotypes.size());
+    EXPECT_EQ(std::vector<int>({0, 2}), obs.haplotypes[0]->ReadIds());
+    EXPECT_EQ(std::vector<int>({1, 4}), obs.haplotypes[1]->ReadIds());
+    EXPECT_EQ(std::vector<int>({3}), obs.haplotypes[2]->ReadIds());
+    EXPECT_EQ("G-TGCT", obs.haplotypes[0]->ConcatCodons());
+    EXPECT_EQ("GNTGCT", obs.haplotypes[1]->ConcatCodons());
+}
+
+TEST(HaplotypeIndexTest, CollapseEqualsNaive)
+{
+    const std::vector<std::string> pool{"GCT", "GCC", "GAA", "G-T", "GNT", "  T", "AAA"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+    std::vector<std::vector<std::string>> rows(2000, std::vector<std::string>(3));
+    for (auto& row : rows)
+        for (auto& codon : row)
+            codon = pool[pick(rng)];
+
+    // Haplotypes in order of their first read, with all their reads
+    std::map<std::vector<std::string>, size_t> firstRow;
+    std::vector<std::vector<int>> naive;
+    std::vector<std::vector<std::string>> naiveCodons;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        const auto it = firstRow.find(rows[r]);
+        if (it == firstRow.cend()) {
+            firstRow.emplace(rows[r], naive.size());
+            naive.push_back({static_cast<int>(r)});
+            naiveCodons.push_back(rows[r]);
+        } else {
+            naive[it->second].push_back(r);
+        }
+    }
+
+    // Full hashes, and hashes reduced to four values to collide
+    for (const uint64_t hashMask : {~uint64_t(0), uint64_t(3)}) {
+        const auto obs = Collapse(rows, hashMask);
+        ASSERT_EQ(naive.size(), obs.haplotypes.size());
+        for (size_t i = 0; i < naive.size(); ++i) {
+            EXPECT_EQ(naive[i], obs.haplotypes[i]->ReadIds());
+            for (size_t j = 0; j < naiveCodons[i].size(); ++j)
+                EXPECT_EQ(naiveCodons[i][j], obs.haplotypes[i]->Codon(j));
+        }
+    }
+}
+}
@@ -0,0 +1,172 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/data/ArrayRead.h>
+#include <pacbio/data/MSA.h>
+
+#include "TestArrayRead.h"
+
+using namespace PacBio::Data;  // NOLINT
+
+namespace {
+
+void ExpectEqualColumns(const MSAByColumn& expected, const MSAByColumn& actual)
+{
+    ASSERT_EQ(expected.BeginPos(), actual.BeginPos());
+    ASSERT_EQ(expected.EndPos(), actual.EndPos());
+    ASSERT_EQ(expected.cend() - expected.cbegin(), actual.cend() - actual.cbegin());
+    for (auto e = expected.cbegin(), a = actual.cbegin(); e != expected.cend(); ++e, ++a) {
+        EXPECT_EQ(e->RefPos(), a->RefPos());
+        for (const char c : {'A', 'C', 'G', 'T', '-', 'N'})
+            EXPECT_EQ((*e)[c], (*a)[c]) << "Base " << c << " at " << e->RefPos();
+        EXPECT_EQ(e->Insertions(), a->Insertions()) << "Insertions at " << e->RefPos();
+    }
+}
+
+TEST(MSATest, StreamingEqualsBatchColumns)
+{
+    // Reads in 0-based reference positions; later reads extend the MSA to
+    // the left. '-' and '*' are placeholders for D and P.
+    const std::vector<std::shared_ptr<ArrayRead>> reads{
+        // [10, 20)
+        std::make_shared<TestArrayRead>(0, 10, "==========", "ACGTACGTAC"),
+        // Soft clip, insertion GG before 10, deletion at 14, padding
+        std::make_shared<TestArrayRead>(1, 5, "SS=====II====DP==", "TTACGTAGGCGTA-*CG"),
+        // N at 15, insertion TT after its last column 15, kept by the clip
+        std::make_shared<TestArrayRead>(2, 12, "====IIS", "ACGNTTA"),
+        // Padding before the first base, insertion G before 19
+        std::make_shared<TestArrayRead>(3, 18, "P=I=", "*AGC"),
+        // Trailing insertion without a following operation is dropped
+        std::make_shared<TestArrayRead>(4, 2, "==I", "ACT")};
+
+    const MSAByColumn batch{MSAByRow(reads)};
+    MSAByColumn stream;
+    for (const auto& r : reads)
+        stream.AddRead(*r);
+
+    ExpectEqualColumns(batch, stream);
+
+    EXPECT_EQ(2, stream.BeginPos());
+    EXPECT_EQ(20, stream.EndPos());
+    EXPECT_EQ(1, stream[10].Insertions().at("GG"));
+    EXPECT_EQ(1, stream[14]['-']);
+    EXPECT_EQ(1, stream[15]['N']);
+    EXPECT_EQ(1, stream[16].Insertions().at("TT"));
+    EXPECT_EQ(1, stream[19].Insertions().at("G"));
+    EXPECT_EQ(0, stream[4].Coverage());
+    for (const auto& column : stream) {
+        if (column.RefPos() != 11 && column.RefPos() != 17 && column.RefPos() != 20) {
+            EXPECT_TRUE(column.Insertions().empty()) << column.RefPos();
+        }
+    }
+}
+
+TEST(MSATest, StreamingKeepsInsertionAfterLastColumn)
+{
+    MSAByColumn stream;
+    stream.AddRead(TestArrayRead(0, 0, "===IIS", "ACGTTA"));
+
+    // The insertion adds an empty column after the end of the read
+    EXPECT_EQ(0, stream.BeginPos());
+    EXPECT_EQ(4, stream.EndPos());
+    EXPECT_EQ(0, stream[3].Coverage());
+    EXPECT_EQ(1, stream[3].Insertions().at("TT"));
+}
+
+TEST(MSATest, WeightedCodonTensor)
+{
+    // Codon CGT starts at window position 1, CodonAt omits the first column
+    std::vector<std::shared_ptr<ArrayRead>> withQVs;
+    std::vector<std::shared_ptr<ArrayRead>> withoutQVs;
+    for (int i = 0; i < 10; ++i) {
+        withQVs.emplace_back(std::make_shared<TestArrayRead>(i, 0, "======", "ACGTAC", 20));
+        withoutQVs.emplace_back(std::make_shared<TestArrayRead>(i, 0, "======", "ACGTAC", 0));
+    }
+    const auto cgt = AminoAcidTable::ToCodonId('C', 'G', 'T');
+    const auto tac = AminoAcidTable::ToCodonId('T', 'A', 'C');
+
+    // QV 20 is correct with probability 0.99
+    const auto weighted = MSAByRow(withQVs, true).WeightedCodonTensor();
+    ASSERT_EQ(6u, weighted.size());
+    EXPECT_NEAR(10 * 0.99 * 0.99 * 0.99, weighted[1][cgt], 1e-4);
+    EXPECT_NEAR(10 * 0.99 * 0.99 * 0.99, weighted[3][tac], 1e-4);
+    EXPECT_EQ(0, weighted[0][cgt]);
+
+    // Records without base qualities store QV 0, those bases are trusted
+    const auto trusted = MSAByRow(withoutQVs, true).WeightedCodonTensor();
+    EXPECT_NEAR(10, trusted[1][cgt], 1e-6);
+    EXPECT_NEAR(10, trusted[3][tac], 1e-6);
+    EXPECT_EQ(10, MSAByRow(withoutQVs).CodonTensor()[1][cgt]);
+
+    EXPECT_THROW(MSAByRow(withQVs).WeightedCodonTensor(), std::runtime_error);
+}
+
+TEST(MSATest, CodonTensorOfAllThreeFrames)
+{
+    // Window position i counts the codons starting at i, thus positions
+    // 3, 4, and 5 hold the second codon of frames 1, 2, and 3
+    std::vector<std::shared_ptr<ArrayRead>> reads;
+    reads.emplace_back(std::make_shared<TestArrayRead>(0, 0, "=========", "ACGTTGCAA"));
+    reads.emplace_back(std::make_shared<TestArrayRead>(1, 1, "========", "CGTTGCAA"));
+    const auto tensor = MSAByRow(reads).CodonTensor();
+    ASSERT_EQ(9u, tensor.size());
+
+    const auto Codons = [&tensor](const int winPos) {
+        std::map<std::string, int> codons;
+        for (int c = 0; c < AminoAcidTable::NumCodons; ++c)
+            if (tensor[winPos][c] > 0) codons[AminoAcidTable::ToCodon(c)] = tensor[winPos][c];
+        return codons;
+    };
+    EXPECT_EQ((std::map<std::string, int>{{"TTG", 2}}), Codons(3));
+    EXPECT_EQ((std::map<std::string, int>{{"TGC", 2}}), Codons(4));
+    EXPECT_EQ((std::map<std::string, int>{{"GCA", 2}}), Codons(5));
+    // Codons end at the last column
+    EXPECT_EQ((std::map<std::string, int>{{"CAA", 2}}), Codons(6));
+    EXPECT_TRUE(Codons(7).empty());
+    EXPECT_TRUE(Codons(8).empty());
+}
+}
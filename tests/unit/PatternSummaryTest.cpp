@@ -0,0 +1,171 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/juliet/PatternSummary.h>
+
+using namespace PacBio::Juliet;  // NOLINT
+
+namespace {
+
+std::map<std::string, int> CountsOf(const PatternSummary& summary)
+{
+    std::map<std::string, int> counts;
+    for (const auto& c : summary.Counters())
+        counts[c.pattern] = c.count;
+    return counts;
+}
+
+// Each tracked count lies in [true, true + error], no untracked pattern
+// occurred more often than MinCount, and a pattern occurring more often
+// than MinCount is tracked.
+void ExpectBounded(const PatternSummary& summary, const std::map<std::string, int>& truth)
+{
+    std::map<std::string, int> tracked;
+    for (const auto& c : summary.Counters()) {
+        const int expected = truth.count(c.pattern) ? truth.at(c.pattern) : 0;
+        EXPECT_LE(expected, c.count) << c.pattern;
+        EXPECT_LE(c.count, expected + c.error) << c.pattern;
+        tracked[c.pattern] = c.count;
+    }
+    for (const auto& t : truth) {
+        if (tracked.find(t.first) == tracked.cend()) {
+            EXPECT_LE(t.second, summary.MinCount());
+        }
+    }
+}
+
+TEST(PatternSummaryTest, CountsExactlyBelowCapacity)
+{
+    PatternSummary summary(3);
+    summary.Add("A", HaplotypeType::REPORT);
+    summary.Add("B", HaplotypeType::PARTIAL);
+    summary.Add("A", HaplotypeType::REPORT, 2);
+    EXPECT_EQ(0, summary.MinCount());
+
+    ASSERT_EQ(2u, summary.Counters().size());
+    EXPECT_EQ("A", summary.Counters()[0].pattern);
+    EXPECT_EQ(3, summary.Counters()[0].count);
+    EXPECT_EQ(0, summary.Counters()[0].error);
+    EXPECT_EQ(HaplotypeType::PARTIAL, summary.Counters()[1].flag);
+    EXPECT_EQ(1, summary.Counters()[1].count);
+}
+
+TEST(PatternSummaryTest, ReplacesSmallestCounter)
+{
+    PatternSummary summary(2);
+    summary.Add("A", HaplotypeType::REPORT, 5);
+    summary.Add("B", HaplotypeType::REPORT, 2);
+    EXPECT_EQ(2, summary.MinCount());
+
+    // C evicts B and inherits its count as error
+    summary.Add("C", HaplotypeType::REPORT);
+    const auto counts = CountsOf(summary);
+    EXPECT_EQ(0u, counts.count("B"));
+    EXPECT_EQ(5, counts.at("A"));
+    EXPECT_EQ(3, counts.at("C"));
+    for (const auto& c : summary.Counters()) {
+        if (c.pattern == "C") {
+            EXPECT_EQ(2, c.error);
+        }
+    }
+    EXPECT_EQ(3, summary.MinCount());
+}
+
+TEST(PatternSummaryTest, MergeAddsMinCountOfFullSummary)
+{
+    PatternSummary a(3);
+    a.Add("A", HaplotypeType::REPORT, 4);
+    a.Add("B", HaplotypeType::REPORT, 1);
+    PatternSummary b(2);
+    b.Add("A", HaplotypeType::REPORT, 3);
+    b.Add("C", HaplotypeType::REPORT, 2);
+    b.Add("D", HaplotypeType::REPORT, 1);  // evicts C
+    ASSERT_EQ(3, b.MinCount());
+
+    a.Merge(b);
+    ASSERT_EQ(3u, a.Counters().size());
+    EXPECT_EQ("A", a.Counters()[0].pattern);
+    EXPECT_EQ(7, a.Counters()[0].count);
+    EXPECT_EQ(0, a.Counters()[0].error);
+    // B may have occurred up to three times in b
+    EXPECT_EQ("B", a.Counters()[1].pattern);
+    EXPECT_EQ(4, a.Counters()[1].count);
+    EXPECT_EQ(3, a.Counters()[1].error);
+    // a is not full, thus D did not occur in a
+    EXPECT_EQ("D", a.Counters()[2].pattern);
+    EXPECT_EQ(3, a.Counters()[2].count);
+    EXPECT_EQ(2, a.Counters()[2].error);
+}
+
+TEST(PatternSummaryTest, BoundsErrorOfSkewedStream)
+{
+    std::mt19937 rng(42);
+    // Few frequent and many rare patterns
+    std::discrete_distribution<int> dist({400, 200, 100, 50, 25, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+                                          5,   5,   5,   5,  5,  5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5});
+
+    std::vector<std::map<std::string, int>> truths(4);
+    std::map<std::string, int> truth;
+    std::vector<PatternSummary> slices(4, PatternSummary(8));
+    for (int i = 0; i < 4000; ++i) {
+        const std::string pattern = "P" + std::to_string(dist(rng));
+        const int slice = i * 4 / 4000;
+        slices[slice].Add(pattern, HaplotypeType::REPORT);
+        ++truths[slice][pattern];
+        ++truth[pattern];
+    }
+    for (int s = 0; s < 4; ++s)
+        ExpectBounded(slices[s], truths[s]);
+
+    for (int s = 1; s < 4; ++s)
+        slices.front().Merge(slices[s]);
+    ExpectBounded(slices.front(), truth);
+
+    // The frequent patterns survive
+    const auto counts = CountsOf(slices.front());
+    for (const std::string p : {"P0", "P1", "P2"})
+        EXPECT_EQ(1u, counts.count(p)) << p;
+}
+}
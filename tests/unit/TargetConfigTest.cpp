@@ -0,0 +1,146 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/juliet/TargetConfig.h>
+
+using namespace PacBio::Juliet;  // NOLINT
+
+namespace {
+
+// Gene of 100 amino acids, drugs sharing and overlapping positions
+TargetGene DrmGene()
+{
+    DRM a;
+    a.name = "A";
+    a.positions = {{'K', 1, 'N'}, {'M', 50, 'V'}};
+    DRM b;
+    b.name = "B";
+    b.positions = {{'M', 50, '*'}, {'M', 50, 'I'}};
+    DRM c;
+    c.name = "C";
+    c.positions = {{'L', 100, 'F'}};
+    return TargetGene(1000, 1300, "gene", {a, b, c});
+}
+
+TEST(TargetConfigTest, HasDRMsOnlyAtAnnotatedPositions)
+{
+    const auto gene = DrmGene();
+    EXPECT_TRUE(gene.HasDRMs(1));
+    EXPECT_TRUE(gene.HasDRMs(50));
+    EXPECT_TRUE(gene.HasDRMs(100));
+    EXPECT_FALSE(gene.HasDRMs(0));
+    EXPECT_FALSE(gene.HasDRMs(2));
+    EXPECT_FALSE(gene.HasDRMs(99));
+    EXPECT_FALSE(gene.HasDRMs(101));
+}
+
+TEST(TargetConfigTest, FindDRMsOnGeneBoundaries)
+{
+    const auto gene = DrmGene();
+    // First and last amino acid of the gene
+    EXPECT_EQ("A", gene.FindDRMs({'K', 1, 'N'}));
+    EXPECT_EQ("", gene.FindDRMs({'K', 1, 'R'}));
+    EXPECT_EQ("C", gene.FindDRMs({'L', 100, 'F'}));
+    EXPECT_EQ("", gene.FindDRMs({'L', 0, 'F'}));
+    EXPECT_EQ("", gene.FindDRMs({'L', 101, 'F'}));
+}
+
+TEST(TargetConfigTest, FindDRMsListsEachDrugOnceInOrder)
+{
+    const auto gene = DrmGene();
+    EXPECT_EQ("A + B", gene.FindDRMs({'M', 50, 'V'}));
+    // B matches twice, by wildcard and exactly
+    EXPECT_EQ("B", gene.FindDRMs({'M', 50, 'I'}));
+    EXPECT_EQ("B", gene.FindDRMs({'M', 50, 'L'}));
+    EXPECT_EQ("", gene.FindDRMs({'A', 50, 'V'}));
+}
+
+TEST(TargetConfigTest, IndexDRMsAfterModification)
+{
+    auto gene = DrmGene();
+    gene.drms.pop_back();
+    gene.drms.front().positions.emplace_back('Q', 99, 'R');
+    gene.IndexDRMs();
+    EXPECT_FALSE(gene.HasDRMs(100));
+    EXPECT_EQ("", gene.FindDRMs({'L', 100, 'F'}));
+    EXPECT_TRUE(gene.HasDRMs(99));
+    EXPECT_EQ("A", gene.FindDRMs({'Q', 99, 'R'}));
+}
+
+TEST(TargetConfigTest, GeneIndexWithOverlappingAndNestedGenes)
+{
+    // Unsorted input, gene 1 nests genes 2 and 3, genes 3 and 0 overlap,
+    // gene 4 has no length, gene 5 is disjoint, gene 6 shares the begin of gene 1
+    std::vector<TargetGene> genes{{500, 900, "0", {}}, {100, 1000, "1", {}}, {200, 300, "2", {}},
+                                  {250, 600, "3", {}}, {700, 700, "4", {}},  {2000, 2100, "5", {}},
+                                  {100, 150, "6", {}}};
+    const TargetGeneIndex index(genes);
+
+    using Indices = std::vector<size_t>;
+    EXPECT_EQ(Indices({1, 2, 6}), index.Overlapping(0, 201));
+    EXPECT_EQ(Indices({1, 3}), index.Overlapping(300, 500));
+    EXPECT_EQ(Indices({0, 1, 4}), index.Overlapping(600, 1000));
+    EXPECT_EQ(Indices({0, 1, 2, 3, 4, 6}), index.Overlapping(100, 1000));
+    // Ranges are half-open
+    EXPECT_EQ(Indices(), index.Overlapping(1000, 2000));
+    EXPECT_EQ(Indices({5}), index.Overlapping(1000, 2001));
+    EXPECT_EQ(Indices({5}), index.Overlapping(2099, 3000));
+    EXPECT_EQ(Indices(), index.Overlapping(0, 100));
+
+    // Same as testing each gene
+    for (int begin = 0; begin < 2200; begin += 50) {
+        for (int end = begin; end < 2200; end += 70) {
+            Indices expected;
+            for (size_t i = 0; i < genes.size(); ++i)
+                if (genes[i].begin < end && genes[i].end > begin) expected.push_back(i);
+            EXPECT_EQ(expected, index.Overlapping(begin, end));
+        }
+    }
+}
+
+TEST(TargetConfigTest, GeneIndexWithoutGenes)
+{
+    const TargetGeneIndex index({});
+    EXPECT_TRUE(index.Overlapping(0, 1000).empty());
+}
+}
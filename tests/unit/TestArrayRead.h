@@ -0,0 +1,68 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <pacbio/data/ArrayRead.h>
+
+namespace PacBio {
+namespace Data {
+
+/// ArrayRead of a given alignment, to test without BAM records.
+class TestArrayRead : public ArrayRead
+{
+public:
+    /// Each character of cigar describes the base at the same index of seq,
+    /// all bases have the same qual QV. The read starts at the 0-based
+    /// reference position referenceStart.
+    TestArrayRead(int idx, int referenceStart, const std::string& cigar, const std::string& seq,
+                  uint8_t qualQV = 60)
+        : ArrayRead(idx, "read/" + std::to_string(idx))
+    {
+        referenceStart_ = referenceStart;
+        referenceEnd_ = referenceStart;
+        for (size_t i = 0; i < cigar.size(); ++i) {
+            bases_.emplace_back(cigar[i], seq[i], qualQV);
+            if (cigar[i] == '=' || cigar[i] == 'X' || cigar[i] == 'D') ++referenceEnd_;
+        }
+    }
+};
+}  // namespace Data
+}  // namespace PacBio
@@ -0,0 +1,137 @@
+// Copyright (c) 2011-2014, Pacific Biosciences of California, Inc.
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted (subject to the limitations in the
+// disclaimer below) provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//
+//  * Neither the name of Pacific Biosciences nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE. THIS SOFTWARE IS PROVIDED BY PACIFIC
+// BIOSCIENCES AND ITS CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL PACIFIC BIOSCIENCES OR ITS
+// CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+// USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+// OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+
+// Author: Armin Töpfer
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <pacbio/data/AminoAcidTable.h>
+#include <pacbio/juliet/VariantGene.h>
+
+using namespace PacBio::Juliet;  // NOLINT
+using PacBio::Data::AminoAcidTable;
+using PacBio::Data::CodonId;
+
+namespace {
+
+using VariantPosition = VariantGene::VariantPosition;
+
+// Reference GCT, alternative reference GCC, variants GAA and GAG (E) and
+// ACT (T)
+std::shared_ptr<VariantPosition> Position()
+{
+    auto vp = std::make_shared<VariantPosition>();
+    vp->refCodon = AminoAcidTable::ToCodonId("GCT");
+    vp->altRefCodon = AminoAcidTable::ToCodonId("GCC");
+    vp->refAminoAcid = 'A';
+    vp->altRefAminoAcid = 'A';
+    vp->coverage = 100;
+    for (const std::string codon : {"GAA", "GAG"})
+        vp->aminoAcidToCodons['E'].push_back({AminoAcidTable::ToCodonId(codon), 0.1, 0.01, ""});
+    vp->aminoAcidToCodons['T'].push_back({AminoAcidTable::ToCodonId("ACT"), 0.1, 0.01, ""});
+    vp->IndexCodons();
+    return vp;
+}
+
+TEST(VariantGeneTest, IsHitOfAcceptedCodons)
+{
+    const auto vp = Position();
+    for (const std::string codon : {"GCT", "GCC", "GAA", "GAG", "ACT"})
+        EXPECT_TRUE(vp->IsHit(AminoAcidTable::ToCodonId(codon))) << codon;
+    for (const std::string codon : {"GCA", "AAA", "TTT", "ACC"})
+        EXPECT_FALSE(vp->IsHit(AminoAcidTable::ToCodonId(codon))) << codon;
+    EXPECT_FALSE(vp->IsHit(AminoAcidTable::InvalidCodon));
+
+    // Without an alternative reference, only the reference is accepted
+    VariantPosition noAltRef;
+    noAltRef.refCodon = AminoAcidTable::ToCodonId("GCT");
+    noAltRef.IndexCodons();
+    EXPECT_TRUE(noAltRef.IsHit(AminoAcidTable::ToCodonId("GCT")));
+    EXPECT_FALSE(noAltRef.IsHit(AminoAcidTable::InvalidCodon));
+    EXPECT_FALSE(noAltRef.IsHit(AminoAcidTable::ToCodonId("GCC")));
+}
+
+TEST(VariantGeneTest, HaplotypeHitsEqualPerCodonLoop)
+{
+    const auto vp = Position();
+
+    // More than 64 haplotypes span multiple words per row
+    const std::vector<std::string> pool{"GCT", "GCC", "GAA", "GAG", "ACT", "TTT", "---", "NCT"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+    std::vector<std::string> haplotypeCodons(130);
+    for (auto& codon : haplotypeCodons)
+        codon = pool[pick(rng)];
+
+    vp->ResetHits(haplotypeCodons.size());
+    for (size_t h = 0; h < haplotypeCodons.size(); ++h) {
+        const CodonId id = AminoAcidTable::ToCodonId(haplotypeCodons[h]);
+        const bool variant = haplotypeCodons[h] == "GAA" || haplotypeCodons[h] == "GAG" ||
+                             haplotypeCodons[h] == "ACT";
+        EXPECT_EQ(variant, vp->SetHit(id, h)) << haplotypeCodons[h];
+    }
+
+    // The per-codon loop, comparing each variant codon to each haplotype
+    VariantGene gene("gene", 0);
+    gene.relPositionToVariant[7] = vp;
+    const auto json = gene.ToJson([](int) { return std::vector<PacBio::JSON::Json>(); });
+    const auto& jVarAAs = json["variant_positions"][0]["variant_amino_acids"];
+    size_t numCodons = 0;
+    for (const auto& jVarAA : jVarAAs) {
+        for (const auto& jCodon : jVarAA["variant_codons"]) {
+            const std::string codon = jCodon["codon"];
+            std::vector<bool> expected;
+            for (const auto& h : haplotypeCodons)
+                expected.push_back(h == codon);
+            EXPECT_EQ(expected, vp->HaplotypeHits(AminoAcidTable::ToCodonId(codon))) << codon;
+            EXPECT_EQ(expected, jCodon["haplotype_hit"].get<std::vector<bool>>()) << codon;
+            ++numCodons;
+        }
+    }
+    EXPECT_EQ(3u, numCodons);
+
+    // Codons without a row have no hits
+    EXPECT_EQ(std::vector<bool>(haplotypeCodons.size(), false),
+              vp->HaplotypeHits(AminoAcidTable::ToCodonId("GCT")));
+    EXPECT_EQ(std::vector<bool>(haplotypeCodons.size(), false),
+              vp->HaplotypeHits(AminoAcidTable::InvalidCodon));
+}
+}